@@ -0,0 +1,173 @@
+/*
+ * Firmware hot-path benchmarks on a host build of Minibot
+ *
+ * Built and run by run_benchmarks.py: minibot.cpp + platform_host.cpp +
+ * this file, with bench/host/ standing in for the Arduino core and LEDC.
+ * minibots.ino is compiled in as-is, so its applyDeadzone() and loop()
+ * are the real thing.
+ *
+ * Prints one JSON object per benchmark: {"name", "unit", "samples"}
+ * where each sample is ns per operation over one batch.
+ */
+
+#include "Arduino.h"
+#include "platform_host.h"
+
+#include "minibots.ino"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t STATION_IP = 0x0201A8C0;  // 192.168.1.2
+volatile float sink;
+
+int repeats = 15;
+int batch = 20000;
+
+void emit(const char* name, const std::vector<double>& samples) {
+    printf("{\"name\": \"firmware.%s\", \"unit\": \"ns/op\", \"samples\": [", name);
+    for (size_t i = 0; i < samples.size(); i++) {
+        printf("%s%.2f", i ? ", " : "", samples[i]);
+    }
+    printf("]}\n");
+    fflush(stdout);
+}
+
+// setup() runs before every batch so state left by one benchmark doesn't
+// leak into the next; op() is what gets timed
+void bench(const char* name, const std::function<void()>& setup, const std::function<void(int)>& op) {
+    std::vector<double> samples;
+    setup();
+    for (int i = 0; i < batch / 10; i++) op(i);  // warm up
+    for (int r = 0; r < repeats; r++) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < batch; i++) op(i);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / batch);
+    }
+    emit(name, samples);
+}
+
+void queueText(const char* text) {
+    platform::host::queuePacket(STATION_IP, text, strlen(text));
+}
+
+void queueFrame(uint16_t seq, uint32_t stamp) {
+    uint8_t frame[FRAME_STAMPED_LEN] = {};
+    strncpy((char*)frame, ROBOT_NAME, 15);
+    frame[16] = 127 + (seq & 63);
+    frame[17] = 127 - (seq & 63);
+    frame[18] = 127;
+    frame[19] = 200;
+    frame[20] = frame[21] = 127;
+    frame[22] = seq & 0x0F;
+    frame[24] = seq & 0xFF;
+    frame[25] = seq >> 8;
+    memcpy(frame + 26, &stamp, 4);
+    platform::host::queuePacket(STATION_IP, frame, sizeof(frame));
+}
+
+// Paired and in teleop, nothing queued, playout off
+void connectedTeleop() {
+    static bool paired = false;
+    while (platform::host::packetsQueued()) bot.updateController();
+    bot.enablePlayoutBuffer(false);
+    if (!paired) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "PORT:%s:12346", ROBOT_NAME);
+        queueText(msg);
+        bot.updateController();
+        paired = true;
+    }
+    queueText("ESTOP_OFF");
+    queueText(ROBOT_NAME ":teleop");
+    bot.updateController();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--repeats") == 0) repeats = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0) batch = atoi(argv[++i]);
+    }
+    setup();
+
+    bench("update_idle", connectedTeleop, [](int) {
+        bot.updateController();
+    });
+
+    uint16_t seq = 0;
+    bench("update_control_frame", connectedTeleop, [&](int) {
+        platform::host::advanceMs(1);
+        queueFrame(++seq, platform::millis());
+        bot.updateController();
+    });
+
+    bench("update_control_frame_playout", [&] {
+        connectedTeleop();
+        bot.enablePlayoutBuffer(true);
+    }, [&](int) {
+        platform::host::advanceMs(1);
+        queueFrame(++seq, platform::millis());
+        bot.updateController();
+    });
+
+    bench("update_game_status", connectedTeleop, [](int) {
+        queueText(ROBOT_NAME ":teleop");
+        bot.updateController();
+    });
+
+    bench("update_estop", connectedTeleop, [](int i) {
+        queueText(i & 1 ? "ESTOP_OFF" : "ESTOP");
+        bot.updateController();
+    });
+
+    // One status packet keeps the session alive; compare with update_game_status
+    bench("update_telemetry_tick", connectedTeleop, [](int) {
+        platform::host::advanceMs(TELEMETRY_INTERVAL_MS);
+        queueText(ROBOT_NAME ":teleop");
+        bot.updateController();
+    });
+
+    bench("update_foreign_frame", connectedTeleop, [&](int) {
+        uint8_t frame[FRAME_STAMPED_LEN] = {};
+        strncpy((char*)frame, "someoneElse", 15);
+        platform::host::queuePacket(STATION_IP, frame, sizeof(frame));
+        bot.updateController();
+    });
+
+    // A full call's worth of junk ahead of one real frame: the per-call
+    // worst case the receive budget allows
+    bench("update_flood", connectedTeleop, [&](int) {
+        platform::host::advanceMs(1);
+        for(int i = 0; i < MAX_PACKETS_PER_LOOP - 1; i++) queueText("flood flood flood");
+        queueFrame(++seq, platform::millis());
+        bot.updateController();
+    });
+
+    bench("write_motor", connectedTeleop, [](int i) {
+        bot.driveLeft((i % 200 - 100) / 100.0f);
+    });
+
+    bench("input_shaping", [] {}, [](int i) {
+        sink = applyDeadzone(i & 0xFF) + applyDeadzone((i >> 3) & 0xFF) + applyDeadzone((i >> 5) & 0xFF);
+    });
+
+    // The sketch's whole loop(): frame in, shaping, both motors, delay(10)
+    bench("sketch_loop", connectedTeleop, [&](int) {
+        queueFrame(++seq, platform::millis());
+        loop();
+    });
+
+    return 0;
+}
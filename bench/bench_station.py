@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Station hot-path benchmarks, run by run_benchmarks.py
+
+Builds a DriverStation without its window, joystick scan or network
+thread and times the per-frame and per-packet work directly. Prints one
+JSON object per benchmark: {"name", "unit", "samples"[, "tolerance"]}
+where each sample is ns per operation over one batch. Benchmarks that go
+through the kernel's socket path carry a looser tolerance.
+"""
+
+import argparse
+import json
+import os
+import socket
+import sys
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, ROOT)
+sys.path.insert(0, os.path.join(ROOT, "native"))
+os.environ.setdefault("PYGAME_HIDE_SUPPORT_PROMPT", "1")
+
+import driver_station  # noqa: E402
+from driver_station import ControllerState, DriverStation, RobotInfo  # noqa: E402
+
+ROBOTS = 4
+
+
+class NullSocket:
+    """Stands in for the station socket when only encoding is timed"""
+
+    def sendto(self, data, addr):
+        return len(data)
+
+
+def make_station(sock) -> DriverStation:
+    """DriverStation state as __init__ leaves it, without pygame or threads"""
+    ds = DriverStation.__new__(DriverStation)
+    ds.udp_socket = sock
+    ds.kernel_timestamps = False
+    ds.robots = {}
+    ds.controllers = {}
+    ds.robot_controller_pairs = {}
+    ds.game_status = "teleop"
+    ds.emergency_stop = False
+    ds.running = True
+    ds.surveys = {}
+    ds.recommended_channel = None
+    ds.profiler = driver_station.SamplingProfiler({})
+    ds.realtime = None
+    ds.manual_gc = False
+    ds.tx = None
+    ds.tx_socket = None
+    ds._tx_robots = {}
+    ds._tx_sent = {}
+    ds._init_metrics()
+    return ds
+
+
+def add_robots(ds: DriverStation, port: int):
+    for i in range(ROBOTS):
+        robot_id = f"benchBot{i}"
+        ds.robots[robot_id] = RobotInfo(robot_id=robot_id, ip="127.0.0.1", port=port,
+                                        last_seen=time.time(), connected=True)
+        ds.controllers[i] = ControllerState(index=i, name="bench", joystick=None, connected=True,
+                                            left_x=40 + i, left_y=200, cross=True)
+        ds.robot_controller_pairs[robot_id] = i
+
+
+def run(name, op, repeats, batch, tolerance=None):
+    for _ in range(max(1, batch // 10)):  # warm up
+        op()
+    samples = []
+    for _ in range(repeats):
+        start = time.perf_counter_ns()
+        for _ in range(batch):
+            op()
+        samples.append(round((time.perf_counter_ns() - start) / batch, 2))
+    result = {"name": f"station.{name}", "unit": "ns/op", "samples": samples}
+    if tolerance is not None:
+        result["tolerance"] = tolerance
+    print(json.dumps(result), flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Station hot-path benchmarks")
+    parser.add_argument("--repeats", type=int, default=15)
+    parser.add_argument("--batch", type=int, default=2000)
+    args = parser.parse_args()
+    repeats, batch = args.repeats, args.batch
+
+    sink = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sink.bind(("127.0.0.1", 0))
+    sink.setblocking(False)
+    sink_port = sink.getsockname()[1]
+
+    def drain():
+        try:
+            while True:
+                sink.recv(64)
+        except BlockingIOError:
+            pass
+
+    # One controller frame: pack + the NullSocket's sendto
+    ds = make_station(NullSocket())
+    add_robots(ds, sink_port)
+    controller = ds.controllers[0]
+    run("encode_frame", lambda: ds._send_controller_data("benchBot0", controller), repeats, batch)
+
+    # One send tick for every paired robot over a real loopback socket
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    ds = make_station(sender)
+    add_robots(ds, sink_port)
+    pairs = list(ds.robot_controller_pairs.items())
+
+    def send_tick():
+        for robot_id, index in pairs:
+            ds._send_controller_data(robot_id, ds.controllers[index])
+        drain()
+    run("send_tick_4_robots", send_tick, repeats, batch // 4, tolerance=0.25)
+
+    # Handing the same tick to the native transmit thread instead
+    if driver_station.station_tx is not None:
+        ds.tx = driver_station.station_tx.Transmitter(sender.fileno(), 60.0)
+        run("sync_native_4_robots", ds._sync_native_tx, repeats, batch // 4)
+        ds.tx = None
+
+    # Packet handling on the network thread; replies go to the sink
+    ds = make_station(sender)
+    add_robots(ds, sink_port)
+    discover = f"DISCOVER:benchBot0:127.0.0.1:{sink_port}"
+
+    def ingest_discover():
+        ds._handle_packet(discover, time.monotonic())
+        drain()
+    run("ingest_discover", ingest_discover, repeats, batch, tolerance=0.25)
+
+    # Same keys minibot.cpp sendTelemetry() reports
+    telem = ("TELEM:benchBot1:t=123456,rx=4000,seq=4000,echo=98765,hold=4,jb=2,jbd=1,jit=2,late=1"
+             ",lnk=1,out=850,outmax=850,outsum=850,iplost=0"
+             ",boot=2100,heap=180000,heapmin=170000,pkt=4000,pktus=40,pktmax=300"
+             ",cctl=0,dcmd=0,doth=0,rxcut=0,r201=1")
+    ds.robots["benchBot1"].frames_sent = 0
+
+    def ingest_telemetry():
+        ds.robots["benchBot1"].frames_sent += 60
+        ds._handle_packet(telem, time.monotonic())
+    run("ingest_telemetry", ingest_telemetry, repeats, batch)
+
+    # /metrics scrape with the series the above left behind
+    run("metrics_render", ds.metrics.render, repeats, max(10, batch // 20))
+
+    sender.close()
+    sink.close()
+
+
+if __name__ == "__main__":
+    main()
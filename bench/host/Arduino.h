@@ -0,0 +1,29 @@
+// Host stand-in for the bits of the Arduino core minibots.ino uses, so the
+// sketch's own input shaping and loop() can be benchmarked on a PC
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "minibot_platform.h"
+
+using std::abs;
+using std::max;
+using std::min;
+
+template <class T, class L, class H>
+T constrain(T value, L low, H high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+inline void delay(uint32_t ms) { platform::delayMs(ms); }
+inline uint32_t millis() { return platform::millis(); }
+
+struct HostSerial {
+    template <class... Args> void print(Args...) {}
+    template <class... Args> void println(Args...) {}
+    void begin(long) {}
+};
+static HostSerial Serial;
@@ -0,0 +1,73 @@
+// Host stand-in for ESP-IDF's LEDC driver: keeps duty and hpoint per
+// channel in memory so Minibot's motor code runs unchanged in benchmarks
+#pragma once
+#include <stdint.h>
+
+typedef int esp_err_t;
+typedef enum { LEDC_LOW_SPEED_MODE, LEDC_SPEED_MODE_MAX } ledc_mode_t;
+typedef enum {
+    LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3,
+    LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7, LEDC_CHANNEL_MAX
+} ledc_channel_t;
+typedef enum { LEDC_TIMER_0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3 } ledc_timer_t;
+typedef enum { LEDC_TIMER_16_BIT = 16 } ledc_timer_bit_t;
+typedef enum { LEDC_INTR_DISABLE } ledc_intr_type_t;
+
+typedef struct {
+    ledc_mode_t speed_mode;
+    ledc_timer_bit_t duty_resolution;
+    ledc_timer_t timer_num;
+    uint32_t freq_hz;
+} ledc_timer_config_t;
+
+typedef struct {
+    int gpio_num;
+    ledc_mode_t speed_mode;
+    ledc_channel_t channel;
+    ledc_intr_type_t intr_type;
+    ledc_timer_t timer_sel;
+    uint32_t duty;
+    int hpoint;
+} ledc_channel_config_t;
+
+struct HostLedcChannel {
+    uint32_t duty, pendingDuty, hpoint, pendingHpoint;
+    uint32_t updates;
+};
+
+inline HostLedcChannel* hostLedc() {
+    static HostLedcChannel channels[LEDC_CHANNEL_MAX];
+    return channels;
+}
+
+inline esp_err_t ledc_timer_config(const ledc_timer_config_t*) { return 0; }
+
+inline esp_err_t ledc_channel_config(const ledc_channel_config_t* conf) {
+    HostLedcChannel& ch = hostLedc()[conf->channel];
+    ch.duty = ch.pendingDuty = conf->duty;
+    ch.hpoint = ch.pendingHpoint = conf->hpoint;
+    return 0;
+}
+
+inline esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t channel, uint32_t duty) {
+    hostLedc()[channel].pendingDuty = duty;
+    return 0;
+}
+
+inline esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t, ledc_channel_t channel, uint32_t duty, uint32_t hpoint) {
+    hostLedc()[channel].pendingDuty = duty;
+    hostLedc()[channel].pendingHpoint = hpoint;
+    return 0;
+}
+
+inline esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t channel) {
+    HostLedcChannel& ch = hostLedc()[channel];
+    ch.duty = ch.pendingDuty;
+    ch.hpoint = ch.pendingHpoint;
+    ch.updates++;
+    return 0;
+}
+
+inline uint32_t ledc_get_duty(ledc_mode_t, ledc_channel_t channel) {
+    return hostLedc()[channel].duty;
+}
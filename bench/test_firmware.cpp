@@ -0,0 +1,294 @@
+/*
+ * Behaviour tests for Minibot on the host build
+ *
+ * Built and run by test_firmware.py: minibot.cpp + platform_host.cpp + this
+ * file, with bench/host/ standing in for the Arduino core and LEDC. Every
+ * robot shares one MinibotLink for the life of the process, so each test
+ * runs in a process of its own: test_firmware <name>.
+ *
+ * Prints [OK] and exits 0 on success, prints what failed and exits 1
+ * otherwise.
+ */
+
+#include "Arduino.h"
+#include "platform_host.h"
+#include "minibot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const uint32_t STATION_IP = 0x0201A8C0;  // 192.168.1.2
+const char* ROBOT = "robot1";
+
+#define CHECK(cond, ...)                                  \
+    do {                                                  \
+        if (!(cond)) {                                    \
+            printf("[FAIL] %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                          \
+            printf("\n");                                 \
+            exit(1);                                      \
+        }                                                 \
+    } while (0)
+
+void queueText(const char* text) {
+    platform::host::queuePacket(STATION_IP, text, strlen(text));
+}
+
+void queueFrame(uint16_t seq, uint32_t stamp) {
+    uint8_t frame[FRAME_STAMPED_LEN] = {};
+    strncpy((char*)frame, ROBOT, 15);
+    frame[16] = 64 + (seq & 127);  // a different leftX for every frame in a run
+    frame[17] = frame[18] = frame[19] = frame[20] = frame[21] = 127;
+    frame[24] = seq & 0xFF;
+    frame[25] = seq >> 8;
+    memcpy(frame + 26, &stamp, 4);
+    platform::host::queuePacket(STATION_IP, frame, sizeof(frame));
+}
+
+// Paired on port 12346 and in teleop
+void pairTeleop(Minibot& bot) {
+    queueText("PORT:robot1:12346");
+    bot.updateController();
+    queueText("robot1:teleop");
+    bot.updateController();
+}
+
+// Value of key in the newest telemetry report, forcing one out first
+long telemetry(Minibot& bot, const char* key) {
+    platform::host::advanceMs(TELEMETRY_INTERVAL_MS);
+    queueText("robot1:teleop");  // keeps the session alive across the gap
+    bot.updateController();
+    const char* report = platform::host::lastSent();
+    CHECK(strncmp(report, "TELEM:", 6) == 0, "expected a telemetry report, last sent: %s", report);
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), ",%s=", key);
+    const char* at = strstr(report, pattern);
+    CHECK(at, "no %s in %s", key, report);
+    return atol(at + strlen(pattern));
+}
+
+// Frames sent every 16 ms arrive in clumps of 3 every 48 ms while the loop
+// runs every 10 ms; returns how many distinct frames were applied
+int runClumps(Minibot& bot, uint16_t& seq, int clumps, uint8_t* maxDepth) {
+    int applied = 0;
+    uint8_t lastX = bot.getLeftX();
+    uint32_t nextClump = platform::millis() + 48;
+    uint32_t end = nextClump + clumps * 48;
+    while (platform::millis() < end) {
+        platform::host::advanceMs(10);
+        uint32_t now = platform::millis();
+        if (now >= nextClump) {
+            for (int i = 0; i < 3; i++) queueFrame(++seq, nextClump - 48 + i * 16);
+            nextClump += 48;
+        }
+        bot.updateController();
+        if (bot.getLeftX() != lastX) {
+            applied++;
+            lastX = bot.getLeftX();
+        }
+        if (maxDepth && bot.getPlayoutDepth() > *maxDepth) *maxDepth = bot.getPlayoutDepth();
+    }
+    return applied;
+}
+
+void testPlayoutClumps() {
+    static Minibot bot(ROBOT);
+    pairTeleop(bot);
+    uint16_t seq = 0;
+
+    // Playout off: only the newest frame of each call is applied
+    int applied = runClumps(bot, seq, 100, nullptr);
+    long coalesced = telemetry(bot, "cctl");
+    CHECK(coalesced >= 150, "playout off: expected clumps coalesced, cctl=%ld", coalesced);
+    CHECK(applied <= 150, "playout off: %d of 300 frames applied", applied);
+
+    // Playout on: every frame of a clump is queued and played in turn
+    bot.enablePlayoutBuffer(true);
+    uint8_t maxDepth = 0;
+    applied = runClumps(bot, seq, 100, &maxDepth);
+    long after = telemetry(bot, "cctl");
+    CHECK(after == coalesced, "playout on: %ld frames coalesced", after - coalesced);
+    CHECK(applied >= 280, "playout on: only %d of 300 frames applied", applied);
+    CHECK(maxDepth >= 2, "playout on: jitter buffer never held a clump (max depth %u)", maxDepth);
+    printf("[OK] playout_clumps: %d of 300 frames applied, max depth %u\n", applied, maxDepth);
+}
+
+// Channel 0 and 1 belong to the first robot declared
+const uint32_t NEUTRAL_DUTY = (uint32_t)((1.5 / 10.0) * (1 << PWM_RES));
+
+bool motorsNeutral() {
+    return hostLedc()[0].duty == NEUTRAL_DUTY && hostLedc()[1].duty == NEUTRAL_DUTY;
+}
+
+void testEstopThroughFlood() {
+    static Minibot bot(ROBOT);
+    pairTeleop(bot);
+    bot.driveLeft(1.0);
+    bot.driveRight(-1.0);
+    CHECK(!motorsNeutral(), "motors should be driving before the flood");
+
+    // Fill the command port's queue: commands for a robot that isn't here,
+    // then junk, far more than it holds
+    for (int i = 0; i < 20; i++) queueText("PORT:ghost:12399");
+    for (int i = 0; i < 180; i++) queueText("junk junk junk");
+    uint32_t dropped = platform::host::packetsDropped();
+    CHECK(dropped > 0, "the flood should overflow the command port's queue");
+
+    // An ESTOP behind the flood on the command port is lost...
+    queueText("ESTOP");
+    CHECK(platform::host::packetsDropped() == dropped + 1, "ESTOP on the full command port should be dropped");
+
+    // ...the one the station also sends to the control socket is not
+    const char* estop = "ESTOP";
+    platform::host::queueControlPacket(STATION_IP, estop, strlen(estop));
+    bot.updateController();
+    CHECK(motorsNeutral(), "motors should be neutral after one call (duty %u/%u)",
+          hostLedc()[0].duty, hostLedc()[1].duty);
+    bot.driveLeft(1.0);
+    CHECK(motorsNeutral(), "ESTOP should keep the motors neutral");
+
+    // The rest of the flood: its commands and junk run the buckets dry
+    for (int i = 0; i < 8 && platform::host::packetsQueued(); i++) bot.updateController();
+    CHECK(platform::host::packetsQueued() == 0, "the flood should drain within a few calls");
+    long commandDropped = telemetry(bot, "dcmd");
+    long otherDropped = telemetry(bot, "doth");
+    CHECK(commandDropped >= 20 - RX_COMMAND_BURST, "dcmd=%ld, expected the command bucket to run dry", commandDropped);
+    CHECK(otherDropped >= 44 - RX_OTHER_BURST, "doth=%ld, expected the other bucket to run dry", otherDropped);
+    printf("[OK] estop_through_flood: %u packets lost to the full queue, dcmd=%ld, doth=%ld\n",
+           platform::host::packetsDropped(), commandDropped, otherDropped);
+}
+
+// Runs a 10 ms loop for ms; appends when each wifiReconnect() happened,
+// relative to from
+int runLink(Minibot& bot, uint32_t ms, uint32_t from, uint32_t* attempts, int n) {
+    uint32_t last = platform::host::reconnects();
+    for (uint32_t t = 0; t < ms; t += 10) {
+        bot.updateController();
+        if (platform::host::reconnects() != last) {
+            CHECK(n < 16, "too many rejoin attempts");
+            attempts[n++] = platform::millis() - from;
+            last = platform::host::reconnects();
+        }
+        platform::host::advanceMs(10);
+    }
+    return n;
+}
+
+void testRejoinSchedule() {
+    using namespace platform::host;
+    static Minibot bot(ROBOT);
+    bot.updateController();
+    uint32_t attempts[16];
+
+    // AP gone: the first attempt at once, then backing off 0.5 s to 8 s
+    setJoinResult(JOIN_NO_AP);
+    setLink(false, 200);  // WIFI_REASON_BEACON_TIMEOUT
+    uint32_t down = platform::millis();
+    int n = runLink(bot, 24000, down, attempts, 0);
+    const uint32_t expected[] = {0, 500, 1500, 3500, 7500, 15500, 23500};
+    CHECK(n == 7, "%d attempts in 24 s, expected 7", n);
+    for (int i = 0; i < n; i++) {
+        CHECK(attempts[i] == expected[i], "attempt %d at %u ms, expected %u", i, attempts[i], expected[i]);
+    }
+
+    // Back: the next attempt (8 s later) succeeds
+    setJoinResult(JOIN_OK);
+    runLink(bot, 8000, down, attempts, 0);
+    CHECK(bot.isLinkUp(), "link should be back once the AP is");
+
+    // Associated but no address: DHCP is still working on it, no retries
+    setJoinResult(JOIN_NO_DHCP);
+    setLink(false, 200);
+    down = platform::millis();
+    n = runLink(bot, 40000, down, attempts, 0);
+    CHECK(n == 1, "%d attempts while associating, expected only the first", n);
+    setLink(true);  // DHCP answers after all
+    bot.updateController();
+    CHECK(bot.isLinkUp(), "link should be back on GOT_IP");
+
+    // An attempt that never reports back is only retried after the stall
+    // window, and the backoff started over when the link came back
+    setJoinResult(JOIN_SILENT);
+    setLink(false, 200);
+    down = platform::millis();
+    n = runLink(bot, 31000, down, attempts, 0);
+    CHECK(n == 3, "%d attempts in 31 s of silence, expected 3", n);
+    CHECK(attempts[0] == 0, "first attempt at %u ms, expected at once", attempts[0]);
+    CHECK(attempts[1] == WIFI_REJOIN_STALL_MS, "retried at %u ms, expected after the %u ms stall window",
+          attempts[1], WIFI_REJOIN_STALL_MS);
+    CHECK(attempts[2] == 2 * WIFI_REJOIN_STALL_MS, "retried at %u ms, expected %u ms",
+          attempts[2], 2 * WIFI_REJOIN_STALL_MS);
+    printf("[OK] rejoin_schedule: 0 500 1500 3500 7500 15500 23500 ms, none while associating or stalled\n");
+}
+
+void testSurveyRejoinTimeout() {
+    using namespace platform::host;
+    static Minibot bot(ROBOT);
+    queueText("PORT:robot1:12346");
+    bot.updateController();
+
+    // The AP doesn't take the board back after the scan
+    setJoinResult(JOIN_SILENT);
+    queueText("SURVEY");
+    bot.updateController();
+    bot.updateController();
+    CHECK(!bot.isLinkUp(), "link should still be down after a failed survey rejoin");
+    CHECK(bot.getLinkOutages() == 1, "a failed survey rejoin should count as an outage (%u)", bot.getLinkOutages());
+    uint32_t failed = platform::millis();
+
+    // From here on the board is no longer surveying: a real disconnect is
+    // counted by reason and serviceLink() rejoins after it
+    setLink(false, 2);  // WIFI_REASON_AUTH_EXPIRE
+    uint32_t attempts = reconnects();
+    for (int i = 0; i < 10 && reconnects() == attempts; i++) {
+        bot.updateController();
+        advanceMs(10);
+    }
+    CHECK(reconnects() > attempts, "serviceLink() should retry after the disconnect");
+
+    advanceMs(1000);
+    uint32_t back = platform::millis();
+    setLink(true);
+    bot.updateController();
+    CHECK(bot.isLinkUp(), "link should be back on GOT_IP");
+    queueText("PORT:robot1:12346");  // the session timed out while off the air
+    bot.updateController();
+    long outage = telemetry(bot, "out");
+    long reasonCount = telemetry(bot, "r2");
+    CHECK(outage == (long)(back - failed), "outage of %ld ms should run from the failed rejoin (%u ms)",
+          outage, back - failed);
+    CHECK(reasonCount == 1, "r2=%ld, expected the disconnect after the survey counted", reasonCount);
+    printf("[OK] survey_rejoin_timeout: outage of %ld ms counted, r2=%ld\n", outage, reasonCount);
+}
+
+struct Test {
+    const char* name;
+    void (*run)();
+};
+
+const Test TESTS[] = {
+    {"playout_clumps", testPlayoutClumps},
+    {"estop_through_flood", testEstopThroughFlood},
+    {"rejoin_schedule", testRejoinSchedule},
+    {"survey_rejoin_timeout", testSurveyRejoinTimeout},
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 2) {
+        for (const Test& test : TESTS) {
+            if (strcmp(argv[1], test.name) == 0) {
+                test.run();
+                return 0;
+            }
+        }
+    }
+    printf("usage: %s <test>, one of:", argv[0]);
+    for (const Test& test : TESTS) printf(" %s", test.name);
+    printf("\n");
+    return 2;
+}
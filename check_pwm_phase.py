@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+PWM phase check - how many motor pulses are high at the same time
+
+Minibot staggers each LEDC channel's hpoint so the motors' pulses don't all
+start on the same edge. This reproduces the firmware's hpoint math for a
+given configuration and reports the peak overlap, with and without the
+stagger, so you can see what adding another robot/motor does to the supply.
+
+Usage:
+    python check_pwm_phase.py                     # 2 channels, worst-case pulses
+    python check_pwm_phase.py --channels 8
+    python check_pwm_phase.py --pulse-ms 2.0 1.5 1.0 1.5
+"""
+
+import argparse
+import sys
+
+# Must match minibot.h
+PWM_FREQ = 100
+PWM_RES = 16
+PWM_MAX_PULSE_MS = 2.0
+
+
+def phase_span(freq, res, max_pulse_ms):
+    """Counts available for hpoints so the longest pulse never wraps (PWM_PHASE_SPAN)"""
+    period = 1 << res
+    return period - int(max_pulse_ms / (1000.0 / freq) * period)
+
+
+def staggered_hpoints(channels, freq, res, max_pulse_ms):
+    """hpoint per channel, as Minibot::staggerPhases() computes it"""
+    span = phase_span(freq, res, max_pulse_ms)
+    return [span * ch // channels for ch in range(channels)]
+
+
+def pulse_counts(pulse_ms, freq, res):
+    """Duty in counts for a pulse width, as Minibot::writeMotor() computes it"""
+    return int((pulse_ms / (1000.0 / freq)) * (1 << res))
+
+
+def peak_overlap(hpoints, duties, period):
+    """Return (peak number of channels high at once, fraction of the period at that peak)"""
+    events = []
+    for start, duty in zip(hpoints, duties):
+        if duty <= 0:
+            continue
+        end = start + duty
+        if end <= period:
+            events += [(start, 1), (end, -1)]
+        else:
+            # Wrapped pulse: high from start to the end of the period, then from 0
+            events += [(start, 1), (period, -1), (0, 1), (end - period, -1)]
+
+    # Falling edges sort before rising edges at the same count
+    events.sort(key=lambda e: (e[0], e[1]))
+    peak, level, time_at_peak, last = 0, 0, 0, 0
+    for position, step in events:
+        if level == peak and level > 0:
+            time_at_peak += position - last
+        level += step
+        last = position
+        if level > peak:
+            peak, time_at_peak = level, 0
+    return peak, time_at_peak / period
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report peak PWM pulse overlap for a Minibot configuration")
+    parser.add_argument("--channels", type=int, default=2,
+                        help="configured motor channels (2 per robot on the board)")
+    parser.add_argument("--freq", type=int, default=PWM_FREQ, help="PWM frequency in Hz")
+    parser.add_argument("--res", type=int, default=PWM_RES, help="duty resolution in bits")
+    parser.add_argument("--pulse-ms", type=float, nargs="+", default=[PWM_MAX_PULSE_MS],
+                        help="pulse width per channel in ms (one value applies to all)")
+    parser.add_argument("--limit", type=int, default=None,
+                        help="exit with status 1 if the staggered peak overlap exceeds this")
+    args = parser.parse_args()
+
+    if args.channels < 1:
+        parser.error("--channels must be at least 1")
+    pulses = args.pulse_ms * args.channels if len(args.pulse_ms) == 1 else args.pulse_ms
+    if len(pulses) != args.channels:
+        parser.error(f"got {len(pulses)} pulse widths for {args.channels} channels")
+    if max(pulses) > PWM_MAX_PULSE_MS:
+        print(f"Warning: pulses over {PWM_MAX_PULSE_MS}ms may wrap past the end of the period")
+
+    period = 1 << args.res
+    duties = [pulse_counts(p, args.freq, args.res) for p in pulses]
+    hpoints = staggered_hpoints(args.channels, args.freq, args.res, PWM_MAX_PULSE_MS)
+
+    print(f"{args.channels} channel(s), {args.freq}Hz, {args.res}-bit ({period} counts/period)")
+    print("-" * 60)
+    for ch, (hpoint, duty) in enumerate(zip(hpoints, duties)):
+        print(f"  Channel {ch}: hpoint {hpoint:6d} ({hpoint / period:6.1%})  "
+              f"pulse {duty:6d} counts ({pulses[ch]:.2f}ms)")
+    print("-" * 60)
+
+    aligned_peak, aligned_frac = peak_overlap([0] * args.channels, duties, period)
+    staggered_peak, staggered_frac = peak_overlap(hpoints, duties, period)
+    print(f"  All at hpoint 0: peak {aligned_peak} channel(s) high for {aligned_frac:.1%} of the period")
+    print(f"  Staggered:       peak {staggered_peak} channel(s) high for {staggered_frac:.1%} of the period")
+
+    if args.limit is not None and staggered_peak > args.limit:
+        print(f"\nFAIL: peak overlap {staggered_peak} exceeds limit {args.limit}")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
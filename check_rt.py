@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Real-time self-test - is this machine fit to run the driver station at a match?
+
+Runs a thread with the same settings `driver_station.py --realtime` gives the
+transmit path (pinned CPU, SCHED_FIFO, locked memory) and measures how late it
+wakes from an absolute-time sleep, cyclictest style. Leave your usual
+background load running (browser, video call, ...) while it measures.
+
+Uses the native core's measurement loop when native/station_tx is built and a
+Python thread otherwise (which is what the Python send path would see).
+
+Usage:
+    sudo python check_rt.py                    # 30s at 1kHz, CPU/priority as --realtime
+    python check_rt.py --seconds 60 --cpu 3
+    python check_rt.py --no-rt                 # baseline without real-time settings
+"""
+
+import argparse
+import gc
+import os
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "native"))
+
+try:
+    import station_tx
+except ImportError:
+    station_tx = None
+
+# Must match driver_station.py
+FPS = 60
+RT_PRIORITY = 50
+
+# Worst wakeup that still leaves most of a frame for the send itself
+DEFAULT_LIMIT_US = 2000
+
+
+def python_wakeup_latency(seconds, interval_us, cpu, priority):
+    """Same measurement as station_tx.wakeup_latency(), from a Python thread"""
+    result = {'rt_errno': 0}
+    latencies = []
+
+    def worker():
+        try:
+            if cpu >= 0:
+                os.sched_setaffinity(0, {cpu})
+            if priority > 0:
+                os.sched_setscheduler(0, os.SCHED_FIFO, os.sched_param(priority))
+        except OSError as e:
+            result['rt_errno'] = e.errno
+        interval = interval_us / 1e6
+        next_wake = time.monotonic()
+        end = next_wake + seconds
+        while next_wake < end:
+            next_wake += interval
+            delay = next_wake - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            latencies.append(time.monotonic() - next_wake)
+
+    thread = threading.Thread(target=worker)
+    thread.start()
+    thread.join()
+
+    latencies.sort()
+    result.update({
+        'samples': len(latencies),
+        'min_s': latencies[0],
+        'avg_s': sum(latencies) / len(latencies),
+        'max_s': latencies[-1],
+        'p99_s': latencies[int(0.99 * (len(latencies) - 1))],
+        'p999_s': latencies[int(0.999 * (len(latencies) - 1))],
+    })
+    return result
+
+
+def lock_memory():
+    try:
+        if station_tx is not None:
+            station_tx.lock_memory()
+        else:
+            import ctypes
+            libc = ctypes.CDLL(None, use_errno=True)
+            if libc.mlockall(1 | 2) != 0:  # MCL_CURRENT | MCL_FUTURE
+                raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()))
+        return "locked"
+    except OSError as e:
+        return f"not locked ({e.strerror})"
+
+
+def main():
+    if not sys.platform.startswith('linux'):
+        print("The real-time self-test needs Linux")
+        sys.exit(2)
+
+    cpus = sorted(os.sched_getaffinity(0))
+    parser = argparse.ArgumentParser(description="Measure worst-case wakeup latency of the transmit path")
+    parser.add_argument("--seconds", type=float, default=30.0, help="how long to measure")
+    parser.add_argument("--interval-us", type=float, default=1000.0, help="wakeup interval")
+    parser.add_argument("--cpu", type=int, default=cpus[-1], help="CPU to pin to (default: the last one)")
+    parser.add_argument("--priority", type=int, default=RT_PRIORITY, help="SCHED_FIFO priority")
+    parser.add_argument("--no-rt", action="store_true", help="measure without pinning, SCHED_FIFO or mlockall")
+    parser.add_argument("--limit-us", type=float, default=DEFAULT_LIMIT_US,
+                        help=f"worst-case wakeup allowed for a PASS (default {DEFAULT_LIMIT_US})")
+    args = parser.parse_args()
+
+    cpu, priority = (-1, 0) if args.no_rt else (args.cpu, args.priority)
+    memory = "not locked (--no-rt)" if args.no_rt else lock_memory()
+    engine = "native" if station_tx is not None else "python"
+
+    print(f"Wakeup latency self-test: {args.seconds:.0f}s at {1e6 / args.interval_us:.0f}Hz ({engine} thread)")
+    print("-" * 60)
+    print(f"  CPU:      {cpu if cpu >= 0 else 'any'} of {cpus}")
+    print(f"  Policy:   {f'SCHED_FIFO {priority}' if priority else 'SCHED_OTHER'}")
+    print(f"  Memory:   {memory}")
+
+    if station_tx is not None:
+        r = station_tx.wakeup_latency(args.seconds, args.interval_us, cpu=cpu, priority=priority)
+    else:
+        gc.disable()  # as on the --realtime Python send path
+        r = python_wakeup_latency(args.seconds, args.interval_us, cpu, priority)
+        gc.enable()
+
+    us = 1e6
+    print("-" * 60)
+    print(f"  Samples:  {r['samples']}")
+    print(f"  Min/avg:  {r['min_s'] * us:.0f}us / {r['avg_s'] * us:.0f}us")
+    print(f"  p99/99.9: {r['p99_s'] * us:.0f}us / {r['p999_s'] * us:.0f}us")
+    print(f"  Worst:    {r['max_s'] * us:.0f}us")
+    print("-" * 60)
+
+    period_us = 1e6 / FPS
+    worst_us = r['max_s'] * us
+    if r['rt_errno']:
+        # The numbers above are for a normal thread, not what --realtime would get
+        print(f"FAIL: real-time settings failed ({os.strerror(r['rt_errno'])}); run as root "
+              f"or grant CAP_SYS_NICE")
+        sys.exit(1)
+    if worst_us > period_us:
+        print(f"FAIL: worst wakeup {worst_us:.0f}us is longer than a frame ({period_us:.0f}us); "
+              f"expect dropped frames at a match")
+        sys.exit(1)
+    if worst_us > args.limit_us:
+        print(f"FAIL: worst wakeup {worst_us:.0f}us exceeds the {args.limit_us:.0f}us limit")
+        sys.exit(1)
+    print(f"PASS: worst wakeup {worst_us:.0f}us (limit {args.limit_us:.0f}us)")
+
+
+if __name__ == "__main__":
+    main()
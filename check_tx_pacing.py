@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Transmit pacing check - how evenly do control frames leave the station?
+
+Sends frames for a few fake robots over loopback and timestamps each arrival
+in the kernel (SO_TIMESTAMPNS), then compares:
+
+    pygame  - the Python path: one sendto per robot, loop paced by clock.tick(FPS)
+    batch   - native core, one sendmmsg per tick
+    soft    - native core, per-robot launch instants via clock_nanosleep
+    txtime  - native core, per-robot launch instants via SO_TXTIME
+
+Loopback has no ETF/fq qdisc, so txtime here only shows the cost of queuing
+ahead; on the robot-facing interface add one first, e.g.
+
+    tc qdisc replace dev wlan0 root fq               # --txtime-clock monotonic
+    tc qdisc replace dev eth0 parent 100:1 etf clockid CLOCK_TAI delta 300000
+
+Usage:
+    python check_tx_pacing.py
+    python check_tx_pacing.py --robots 4 --seconds 5 --load-ms 8   # busy UI thread
+    python check_tx_pacing.py --modes pygame soft
+"""
+
+import argparse
+import os
+import select
+import socket
+import struct
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "native"))
+
+try:
+    import station_tx
+except ImportError:
+    station_tx = None
+
+# Must match driver_station.py
+FPS = 60
+SO_TIMESTAMPNS = getattr(socket, 'SO_TIMESTAMPNS', 35)
+TIMESPEC = struct.Struct('@ll')
+
+MODES = ("pygame", "batch", "soft", "txtime")
+
+
+class Receivers:
+    """One loopback socket per fake robot, recording kernel arrival times"""
+
+    def __init__(self, count):
+        self.socks = []
+        for _ in range(count):
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.setsockopt(socket.SOL_SOCKET, SO_TIMESTAMPNS, 1)
+            sock.bind(('127.0.0.1', 0))
+            self.socks.append(sock)
+        self.ports = [s.getsockname()[1] for s in self.socks]
+        self.arrivals = []  # (kernel time, robot index)
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        self._thread.start()
+
+    def _run(self):
+        index = {s.fileno(): i for i, s in enumerate(self.socks)}
+        while not self._stop.is_set():
+            ready, _, _ = select.select(self.socks, [], [], 0.05)
+            for sock in ready:
+                _data, ancdata, _flags, _addr = sock.recvmsg(64, socket.CMSG_SPACE(TIMESPEC.size))
+                for level, kind, payload in ancdata:
+                    if level == socket.SOL_SOCKET and kind == SO_TIMESTAMPNS:
+                        sec, nsec = TIMESPEC.unpack_from(payload)
+                        self.arrivals.append((sec + nsec * 1e-9, index[sock.fileno()]))
+
+    def close(self):
+        self._stop.set()
+        self._thread.join()
+        for sock in self.socks:
+            sock.close()
+
+
+def busy(ms):
+    """Stand-in for drawing the UI"""
+    end = time.perf_counter() + ms / 1000.0
+    while time.perf_counter() < end:
+        pass
+
+
+def run_pygame(ports, seconds, load_ms):
+    import pygame
+    clock = pygame.time.Clock()
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    frame = bytes(30)
+    end = time.monotonic() + seconds
+    while time.monotonic() < end:
+        for port in ports:
+            sock.sendto(frame, ('127.0.0.1', port))
+        busy(load_ms)
+        clock.tick(FPS)
+    sock.close()
+    return None
+
+
+def run_native(ports, seconds, load_ms, pacing, txtime_clock, lead_us):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sock.fileno(), FPS, pacing=pacing,
+                                txtime_clock=txtime_clock, lead_us=lead_us)
+    robots = [f"robot{i}" for i in range(len(ports))]
+    for robot_id, port in zip(robots, ports):
+        tx.set_robot(robot_id, "127.0.0.1", port)
+    tx.start()
+    end = time.monotonic() + seconds
+    while time.monotonic() < end:
+        # Refresh every robot each tick like driver_station._sync_native_tx(),
+        # or the core stops sending once they go stale
+        for robot_id in robots:
+            tx.set_state(robot_id, 127, 127, 127, 127, 0)
+            tx.set_enabled(robot_id, True)
+        busy(load_ms)
+        time.sleep(1.0 / FPS)
+    tx.stop()
+    sock.close()
+    return tx.stats()
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def summarize(arrivals, robots):
+    """Per-robot interval error against 1/FPS, and how closely frames follow each other"""
+    period = 1.0 / FPS
+    errors = []
+    for robot in range(robots):
+        times = [t for t, r in arrivals if r == robot]
+        errors += [abs((b - a) - period) for a, b in zip(times, times[1:])]
+    ordered = sorted(t for t, _ in arrivals)
+    gaps = [b - a for a, b in zip(ordered, ordered[1:])]
+    if not errors:
+        return None
+    return {
+        'frames': len(arrivals),
+        'mean': sum(errors) / len(errors),
+        'p99': percentile(errors, 0.99),
+        'max': max(errors),
+        'median_gap': percentile(gaps, 0.5) if gaps else 0.0,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare control frame pacing modes over loopback")
+    parser.add_argument("--robots", type=int, default=3, help="fake robots to send to")
+    parser.add_argument("--seconds", type=float, default=3.0, help="duration of each run")
+    parser.add_argument("--load-ms", type=float, default=0.0,
+                        help="busy-work per frame on the main thread (simulated rendering)")
+    parser.add_argument("--modes", nargs="+", choices=MODES, default=list(MODES))
+    parser.add_argument("--txtime-clock", choices=("tai", "monotonic"), default="monotonic",
+                        help="SO_TXTIME clock (tai needs CAP_NET_ADMIN; default monotonic)")
+    parser.add_argument("--lead-us", type=float, default=1000.0,
+                        help="how far ahead txtime frames are queued")
+    args = parser.parse_args()
+
+    print(f"{args.robots} robot(s) at {FPS} Hz for {args.seconds:.0f}s each, "
+          f"{args.load_ms:.1f}ms simulated render load")
+    print("-" * 78)
+    print(f"  {'mode':8s} {'frames':>7s} {'|err| mean':>11s} {'p99':>9s} {'max':>9s} "
+          f"{'med gap':>9s}   notes")
+
+    for mode in args.modes:
+        if mode != "pygame" and station_tx is None:
+            print(f"  {mode:8s} skipped: native/station_tx is not built")
+            continue
+        receivers = Receivers(args.robots)
+        try:
+            if mode == "pygame":
+                stats = run_pygame(receivers.ports, args.seconds, args.load_ms)
+            else:
+                stats = run_native(receivers.ports, args.seconds, args.load_ms, mode,
+                                   args.txtime_clock, args.lead_us)
+        except (ImportError, OSError) as e:
+            print(f"  {mode:8s} skipped: {e}")
+            receivers.close()
+            continue
+        time.sleep(0.1)
+        receivers.close()
+
+        result = summarize(receivers.arrivals, args.robots)
+        if result is None:
+            print(f"  {mode:8s} no frames received")
+            continue
+        notes = ""
+        if stats and mode == "txtime":
+            notes = f"lead min {stats['txtime_lead_min_s'] * 1e6:.0f}us, missed {stats['txtime_missed']}"
+        elif stats:
+            notes = f"send late max {stats['launch_late_max_s'] * 1e6:.0f}us"
+        us = 1e6
+        print(f"  {mode:8s} {result['frames']:7d} {result['mean'] * us:9.0f}us {result['p99'] * us:7.0f}us "
+              f"{result['max'] * us:7.0f}us {result['median_gap'] * us:7.0f}us   {notes}")
+
+    print("-" * 78)
+    print("  |err|: deviation of each robot's frame interval from 1/FPS (kernel rx timestamps)")
+    print("  med gap: typical spacing between consecutive frames; paced modes spread robots across the tick")
+
+
+if __name__ == "__main__":
+    main()
@@ -10,6 +10,9 @@ import threading
 import random
 
 DISCOVERY_PORT = 12345
+# Simulated robots listen for their PORT reply here, clear of the command
+# ports the driver station hands out from 12346 up
+DEMO_REPLY_PORT_BASE = 12400
 
 class SimulatedRobot:
     """Simulates a robot for testing"""
@@ -25,7 +28,7 @@ class SimulatedRobot:
         self.discovery_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
         self.discovery_socket.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
         # Bind to unique port for this robot so multiple can run
-        self.discovery_port = DISCOVERY_PORT + 1 + hash(robot_id) % 10
+        self.discovery_port = DEMO_REPLY_PORT_BASE + hash(robot_id) % 10
         self.discovery_socket.bind(('', self.discovery_port))
         self.discovery_socket.settimeout(0.5)
 
@@ -45,6 +48,21 @@ class SimulatedRobot:
         sock.close()
         print(f"[{self.robot_id}] Sent discovery: {message}")
     
+    def send_survey(self, station_ip):
+        """Answer a channel survey request with a made-up view of the band"""
+        print(f"[{self.robot_id}] Channel survey requested")
+        time.sleep(2)  # a real board is off the air for a few seconds
+        channels = []
+        for channel in range(1, 14):
+            networks = random.choice((0, 0, 1, 2, 4)) if channel in (1, 6, 11) else random.choice((0, 0, 1))
+            rssi = -random.randint(45, 90) if networks else 0
+            busy = random.randint(5, 400) if networks else random.randint(0, 30)
+            channels.append(f"c{channel}={networks}/{rssi}/{busy}/{busy * 3}")
+        message = f"SURVEY:{self.robot_id}:ap=6,dwell=150,off=2000," + ",".join(channels)
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.sendto(message.encode(), (station_ip, DISCOVERY_PORT))
+        sock.close()
+
     def listen_for_commands(self):
         """Listen for port assignment and commands"""
         while self.running:
@@ -82,9 +100,12 @@ class SimulatedRobot:
                 
                 elif message == "ESTOP_OFF":
                     print(f"[{self.robot_id}] Emergency stop released")
+
+                elif message == "SURVEY":
+                    self.send_survey(addr[0])
                 
                 # Controller data (binary)
-                elif len(data) == 24:
+                elif len(data) >= 24:
                     robot_name = data[:16].rstrip(b'\x00').decode('utf-8', errors='ignore')
                     if robot_name == self.robot_id:
                         axes = data[16:22]
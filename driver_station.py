@@ -4,20 +4,78 @@ GUI Driver Station for Minibot Control System
 Supports 2 robots with PS5 controller pairing via pygame
 """
 
+import argparse
+import ctypes
+import gc
+import os
 import pygame
+import signal
 import socket
 import struct
+import sys
 import threading
 import time
 from typing import Dict, Optional, Tuple
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 from datetime import datetime
 
+from station_metrics import Registry, start_http_server, start_textfile_writer
+from station_profiler import SamplingProfiler
+
+try:
+    import fcntl
+    import resource
+    import termios
+except ImportError:  # Windows
+    fcntl = None
+    resource = None
+
+# Native transmit core (Linux, optional): cd native && python setup.py build_ext --inplace
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "native"))
+try:
+    import station_tx
+except ImportError:
+    station_tx = None
+
 # Constants from minibot.h
 DISCOVERY_PORT = 12345
 COMMAND_PORT_BASE = 12346
 WIFI_BROADCAST = "255.255.255.255"
 
+# Kernel receive timestamps (Linux). The socket module doesn't export
+# SO_TIMESTAMPNS; 35 is its value on x86 and ARM.
+SO_TIMESTAMPNS = getattr(socket, 'SO_TIMESTAMPNS', 35)
+TIMESPEC = struct.Struct('@ll')  # struct timespec {tv_sec, tv_nsec}
+CLOCK_SYNC_SAMPLES = 8           # telemetry reports kept for the min-RTT offset filter
+
+# Channel survey ('S' in standby). Robots leave the AP for a few seconds,
+# scan and listen on each channel, and report back; see _recommend_channel().
+SURVEY_CANDIDATES = (1, 6, 11)   # the non-overlapping 20 MHz channels
+SURVEY_NETWORK_COST = 0.02       # airtime an AP's beacons alone take (~2% at 1 Mbps)
+SURVEY_MAX_AGE = 600             # seconds before a board's report stops counting
+
+# Real-time mode (--realtime)
+RT_PRIORITY = 50                 # SCHED_FIFO priority of the transmit path
+RT_GC_MID_EVERY = 10             # seconds between gen 1 collections with the collector off
+RT_GC_FULL_EVERY = 60            # seconds between full collections
+MCL_CURRENT, MCL_FUTURE = 1, 2   # mlockall() flags
+
+# Sampling profiler ('P', SIGUSR1 or --profile). Each sample goes to the
+# subsystem of the innermost of these functions on the sampled thread's stack.
+PROFILE_HZ = 100
+PROFILE_SUBSYSTEMS = {
+    'driver_station.py:_draw_ui': 'render',
+    'driver_station.py:_update_controllers': 'events',
+    'driver_station.py:_send_controller_data': 'encode',
+    'driver_station.py:_sync_native_tx': 'encode',
+    'driver_station.py:_handle_packet': 'network',
+    'driver_station.py:_network_loop': 'network-wait',  # its recv timeout and sleep
+    'driver_station.py:run': 'tick-wait',  # main loop outside the above: mostly clock.tick()
+    'station_metrics.py:do_GET': 'metrics',
+    'station_metrics.py:write_textfile': 'metrics',
+}
+PROFILE_THREADS = {'metrics-http': 'metrics-wait', 'metrics-textfile': 'metrics-wait'}
+
 # Display settings
 SCREEN_WIDTH = 1200
 SCREEN_HEIGHT = 700
@@ -42,6 +100,24 @@ class RobotInfo:
     port: int
     last_seen: float
     connected: bool = False
+    tx_seq: int = 0
+    frames_sent: int = 0
+    telemetry: Dict[str, int] = field(default_factory=dict)
+    rtt_ms: Optional[float] = None
+    loss: Optional[float] = None
+    loss_mark: Optional[Tuple[int, int]] = None  # (frames_sent, rx) at the last report
+    clock_offset_ms: Optional[float] = None  # robot millis() - station monotonic ms
+    sync_samples: list = field(default_factory=list)  # [(rtt_ms, offset_ms), ...]
+
+@dataclass
+class ChannelSurveyReport:
+    """One board's view of the 2.4 GHz band, from a SURVEY packet"""
+    robot_id: str
+    received: float
+    ap_channel: int
+    off_air_ms: int
+    # channel -> (networks, strongest rssi dBm, busy ratio, frames heard)
+    channels: Dict[int, Tuple[int, int, float, int]] = field(default_factory=dict)
 
 @dataclass
 class ControllerState:
@@ -62,7 +138,10 @@ class ControllerState:
 class DriverStation:
     """Main driver station application"""
     
-    def __init__(self):
+    def __init__(self, native_tx: bool = True, tx_pacing: str = "batch",
+                 txtime_clock: str = "tai", txtime_lead_us: float = 1000.0,
+                 realtime: bool = False, rt_cpu: Optional[int] = None, rt_priority: int = RT_PRIORITY,
+                 profile_hz: float = PROFILE_HZ, profile_dir: str = "."):
         pygame.init()
         pygame.joystick.init()
         
@@ -78,6 +157,7 @@ class DriverStation:
         self.udp_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
         self.udp_socket.bind(('', DISCOVERY_PORT))
         self.udp_socket.settimeout(0.1)
+        self.kernel_timestamps = self._enable_kernel_timestamps()
         
         # State
         self.robots: Dict[str, RobotInfo] = {}
@@ -86,9 +166,35 @@ class DriverStation:
         self.game_status = "standby"  # standby, teleop, autonomous
         self.emergency_stop = False
         self.running = True
-        
+        self.surveys: Dict[str, ChannelSurveyReport] = {}  # reporting robot -> its board's report
+        self.recommended_channel: Optional[Tuple[int, float]] = None  # (channel, load)
+        self.profiler = SamplingProfiler(PROFILE_SUBSYSTEMS, PROFILE_THREADS, profile_hz,
+                                         thread_init=self._leave_realtime)
+        self.profile_dir = profile_dir
+        self.profile_toggle = False  # set by SIGUSR1, acted on by the main loop
+
+        self._init_metrics()
+
+        # (cpu, priority) for the transmit path, or None
+        self.realtime = self._prepare_realtime(rt_cpu, rt_priority) if realtime else None
+        self.helper_cpus: Optional[set] = None  # CPUs for threads other than the transmit path
+        self.manual_gc = False
+
+        # Controller frames go out from the native transmit thread when it's
+        # built; otherwise the main loop sends them itself
+        self.tx = None
+        self.tx_socket = None
+        self._tx_robots: Dict[str, Tuple[str, int]] = {}  # robot_id -> address given to tx
+        self._tx_sent: Dict[str, int] = {}  # robot_id -> frames_sent already counted
+        if native_tx and station_tx is not None:
+            self._start_native_tx(tx_pacing, txtime_clock, txtime_lead_us)
+        else:
+            print("Sending controller frames from Python")
+        if self.realtime and self.tx is not None:
+            self._enter_realtime()
+
         # Start network thread
-        self.network_thread = threading.Thread(target=self._network_loop, daemon=True)
+        self.network_thread = threading.Thread(target=self._network_loop, daemon=True, name="network")
         self.network_thread.start()
         
         # Discover controllers
@@ -98,6 +204,239 @@ class DriverStation:
         self.selected_robot = None
         self.selected_controller = None
     
+    def _init_metrics(self):
+        """Counters and histograms for ops dashboards (exported by main())"""
+        m = self.metrics = Registry()
+        self.m_frames_sent = m.counter('ds_frames_sent_total', 'Control frames sent', ['robot'])
+        self.m_send_errors = m.counter('ds_send_errors_total', 'Failed sendto calls')
+        self.m_tick_interval = m.histogram('ds_tick_interval_seconds', 'Time between send ticks')
+        self.m_send_jitter = m.gauge('ds_send_jitter_seconds', 'Smoothed |tick interval - 1/FPS|')
+        self.m_render = m.histogram('ds_render_seconds', 'Time to draw one UI frame')
+        self.m_event_queue = m.gauge('ds_event_queue_depth', 'pygame events handled in the last tick')
+        self.m_packets_rx = m.counter('ds_packets_received_total', 'Packets received by type', ['type'])
+        self.m_discovery = m.counter('ds_discovery_events_total', 'Robot discovery events', ['event'])
+        self.m_rx_delay = m.histogram('ds_rx_delay_seconds',
+                                      'Kernel receive timestamp to Python handling (interpreter/scheduling delay)')
+        self.m_clock_offset = m.gauge('ds_robot_clock_offset_seconds',
+                                      'Robot clock minus station clock (min-RTT filtered)', ['robot'])
+        self.m_rtt = m.histogram('ds_robot_rtt_seconds', 'Round trip time from telemetry echoes', ['robot'])
+        self.m_loss = m.gauge('ds_robot_loss_ratio', 'Control frames lost between telemetry reports', ['robot'])
+        self.m_telemetry = m.gauge('ds_robot_telemetry', 'Latest values reported by the robot', ['robot', 'key'])
+        self.m_channel_busy = m.gauge('ds_channel_busy_ratio',
+                                      'Airtime heard on the channel in the last survey', ['robot', 'channel'])
+        self.m_channel_networks = m.gauge('ds_channel_networks',
+                                          'Access points heard on the channel in the last survey',
+                                          ['robot', 'channel'])
+        # Labelled by robot first; their series go when the robot times out
+        self.m_per_robot = (self.m_frames_sent, self.m_clock_offset, self.m_rtt, self.m_loss,
+                            self.m_telemetry, self.m_channel_busy, self.m_channel_networks)
+        m.gauge('ds_recommended_channel', 'Least congested channel from the fleet survey (0 = none)').set_function(
+            lambda: self.recommended_channel[0] if self.recommended_channel else 0)
+        self.m_profile_samples = m.counter('ds_profile_samples_total',
+                                           'Profiler samples by subsystem, counted when a profile ends',
+                                           ['subsystem'])
+        m.gauge('ds_profiler_running', '1 while the sampling profiler is on').set_function(
+            lambda: 1 if self.profiler.running else 0)
+        m.gauge('ds_robots', 'Discovered robots').set_function(lambda: len(self.robots))
+        m.gauge('ds_paired_robots', 'Robots paired with a controller').set_function(
+            lambda: len(self.robot_controller_pairs))
+        if fcntl is not None:
+            m.gauge('ds_rx_queue_bytes', 'Bytes waiting in the UDP receive queue').set_function(
+                lambda: struct.unpack('i', fcntl.ioctl(self.udp_socket.fileno(), termios.FIONREAD, b'\0' * 4))[0])
+
+    def _start_native_tx(self, pacing: str, txtime_clock: str, lead_us: float):
+        """Hand per-robot frame encoding and sending to native/station_tx"""
+        if pacing == "txtime":
+            # A qdisc that honours SO_TXTIME drops packets without a launch
+            # time, so paced frames get a socket of their own
+            self.tx_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            try:
+                self.tx = station_tx.Transmitter(self.tx_socket.fileno(), FPS, pacing="txtime",
+                                                 txtime_clock=txtime_clock, lead_us=lead_us)
+            except OSError as e:
+                print(f"SO_TXTIME unavailable ({e}), pacing frames in software instead")
+                self.tx_socket.close()
+                self.tx_socket = None
+                pacing = "soft"
+        if self.tx is None:
+            self.tx = station_tx.Transmitter(self.udp_socket.fileno(), FPS, pacing=pacing)
+        if self.realtime:
+            self.tx.set_realtime(*self.realtime)
+        self.tx.start()
+        print(f"Native transmit core running at {FPS} Hz ({pacing} pacing)")
+
+        m = self.metrics
+        m.gauge('ds_native_tx_wake_late_max_seconds', 'Worst transmit thread wakeup delay').set_function(
+            lambda: self.tx.stats()['wake_late_max_s'])
+        m.gauge('ds_native_tx_wake_late_avg_seconds', 'Average transmit thread wakeup delay').set_function(
+            lambda: self.tx.stats()['wake_late_avg_s'])
+        m.gauge('ds_native_tx_overruns', 'Transmit ticks that started a full period late').set_function(
+            lambda: self.tx.stats()['overruns'])
+        m.gauge('ds_native_tx_stalls', 'Robots silenced because the main loop stopped refreshing them').set_function(
+            lambda: self.tx.stats()['stalls'])
+        m.gauge('ds_native_tx_batches', 'sendmmsg calls made by the transmit thread').set_function(
+            lambda: self.tx.stats()['batches'])
+        m.gauge('ds_native_tx_launch_late_max_seconds',
+                'Worst time a send returned after its scheduled launch (batch/soft pacing)').set_function(
+            lambda: self.tx.stats()['launch_late_max_s'])
+        m.gauge('ds_native_tx_txtime_missed', 'Frames the qdisc dropped for missing their launch time').set_function(
+            lambda: self.tx.stats()['txtime_missed'])
+
+    def _prepare_realtime(self, cpu: Optional[int], priority: int) -> Optional[Tuple[int, int]]:
+        """Pick the transmit core and lock memory; returns (cpu, priority) or None"""
+        if not sys.platform.startswith('linux'):
+            print("Real-time mode needs Linux; running normally")
+            return None
+        cpus = sorted(os.sched_getaffinity(0))
+        if cpu is None:
+            cpu = cpus[-1]
+        elif cpu not in cpus:
+            print(f"CPU {cpu} isn't available (have {cpus}); running normally")
+            return None
+
+        # With MCL_FUTURE every later allocation counts against RLIMIT_MEMLOCK,
+        # so only lock when that can't start failing mallocs mid-match
+        soft_limit = resource.getrlimit(resource.RLIMIT_MEMLOCK)[0]
+        if os.geteuid() == 0 or soft_limit == resource.RLIM_INFINITY:
+            try:
+                if station_tx is not None:
+                    station_tx.lock_memory()
+                else:
+                    libc = ctypes.CDLL(None, use_errno=True)
+                    if libc.mlockall(MCL_CURRENT | MCL_FUTURE) != 0:
+                        raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()))
+                print("Memory locked (mlockall)")
+            except OSError as e:
+                print(f"mlockall failed: {e}")
+        else:
+            print("Memory not locked: run as root or raise the memlock limit (ulimit -l unlimited)")
+        return cpu, priority
+
+    def _enter_realtime(self):
+        """Give the transmit path its own core at SCHED_FIFO.
+
+        Threads inherit the policy and mask of the thread that starts them.
+        With the native core this runs from __init__, before the helper
+        threads exist, so they all inherit a mask without the transmit core.
+        On the Python path the main loop is the transmit path: run() calls
+        this once the network and metrics threads are running, and threads
+        started later (the profiler) drop back with _leave_realtime().
+        """
+        cpu, priority = self.realtime
+        cpus = set(os.sched_getaffinity(0))
+        self.helper_cpus = cpus - {cpu} if len(cpus) > 1 else cpus
+        if self.tx is not None:
+            # The native thread pinned itself in set_realtime(); keep the UI
+            # and network threads off its core
+            os.sched_setaffinity(0, self.helper_cpus)
+            time.sleep(0.05)  # let the thread apply its settings
+            error = self.tx.stats()['rt_errno']
+            if error:
+                print(f"Transmit thread real-time settings failed: {os.strerror(error)}")
+            else:
+                print(f"Transmit thread on CPU {cpu} at SCHED_FIFO {priority}")
+            return
+
+        # Python send path: the main loop is the transmit path
+        try:
+            os.sched_setaffinity(0, {cpu})
+            os.sched_setscheduler(0, os.SCHED_FIFO, os.sched_param(priority))
+            print(f"Main loop on CPU {cpu} at SCHED_FIFO {priority}")
+        except OSError as e:
+            print(f"Main loop real-time settings failed: {e}")
+        # No collector pauses between sends: freeze what startup allocated and
+        # collect ourselves right after a send (see _collect_garbage())
+        gc.collect()
+        gc.freeze()
+        gc.disable()
+        self.manual_gc = True
+
+    def _leave_realtime(self):
+        """Put the calling thread back on SCHED_OTHER, off the transmit core"""
+        if self.helper_cpus is None or self.tx is not None:
+            return  # nothing to undo: helpers never inherited SCHED_FIFO
+        try:
+            os.sched_setscheduler(0, os.SCHED_OTHER, os.sched_param(0))
+            os.sched_setaffinity(0, self.helper_cpus)
+        except OSError as e:
+            print(f"Could not reset {threading.current_thread().name} to normal scheduling: {e}")
+
+    def _collect_garbage(self, seconds: int):
+        """Collector off: young generation every second, older ones now and then"""
+        if seconds % RT_GC_FULL_EVERY == 0:
+            gc.collect()
+        elif seconds % RT_GC_MID_EVERY == 0:
+            gc.collect(1)
+        else:
+            gc.collect(0)
+
+    def _sync_native_tx(self):
+        """Push pairings, addresses and the latest controller state to the transmit thread"""
+        sending = self.game_status == "teleop" and not self.emergency_stop
+        active = set()
+
+        for robot_id, controller_index in list(self.robot_controller_pairs.items()):
+            robot_info = self.robots.get(robot_id)
+            controller = self.controllers.get(controller_index)
+            if robot_info is None or controller is None:
+                continue
+            active.add(robot_id)
+
+            address = (robot_info.ip, robot_info.port)
+            if self._tx_robots.get(robot_id) != address:
+                self.tx.set_robot(robot_id, *address)
+                self._tx_robots[robot_id] = address
+            self.tx.set_state(robot_id, controller.left_x, controller.left_y,
+                              controller.right_x, controller.right_y, self._button_byte(controller))
+            self.tx.set_enabled(robot_id, sending and robot_info.connected)
+
+            # Keep the counters the loss calculation and metrics rely on
+            sent = self.tx.robot_stats(robot_id)['frames_sent']
+            delta = sent - self._tx_sent.get(robot_id, 0)
+            if delta > 0:
+                robot_info.frames_sent += delta
+                self.m_frames_sent.labels(robot_id).inc(delta)
+            self._tx_sent[robot_id] = sent
+
+        for robot_id in list(self._tx_robots):
+            if robot_id not in active:
+                self.tx.remove_robot(robot_id)
+                del self._tx_robots[robot_id]
+                self._tx_sent.pop(robot_id, None)
+
+    def _enable_kernel_timestamps(self) -> bool:
+        """Ask the kernel to stamp each datagram as it arrives (Linux only)"""
+        if not sys.platform.startswith('linux') or not hasattr(self.udp_socket, 'recvmsg'):
+            return False
+        try:
+            self.udp_socket.setsockopt(socket.SOL_SOCKET, SO_TIMESTAMPNS, 1)
+            return True
+        except OSError as e:
+            print(f"Kernel receive timestamps unavailable: {e}")
+            return False
+
+    def _receive(self) -> Tuple[bytes, Tuple[str, int], float]:
+        """recvfrom() plus the time.monotonic() at which the packet arrived.
+
+        With kernel timestamps this excludes however long the packet sat in
+        the socket queue waiting for this thread (GIL, scheduling, the
+        network loop's sleep); otherwise it's simply the time we read it.
+        """
+        if not self.kernel_timestamps:
+            data, addr = self.udp_socket.recvfrom(1024)
+            return data, addr, time.monotonic()
+
+        data, ancdata, _flags, addr = self.udp_socket.recvmsg(1024, socket.CMSG_SPACE(TIMESPEC.size))
+        now_mono, now_wall = time.monotonic(), time.time()
+        for level, kind, payload in ancdata:
+            if level == socket.SOL_SOCKET and kind == SO_TIMESTAMPNS and len(payload) >= TIMESPEC.size:
+                sec, nsec = TIMESPEC.unpack_from(payload)
+                # Kernel stamps are CLOCK_REALTIME; carry the age over to monotonic
+                age = max(0.0, now_wall - (sec + nsec * 1e-9))
+                self.m_rx_delay.observe(age)
+                return data, addr, now_mono - age
+        return data, addr, now_mono
+
     def _discover_controllers(self):
         """Discover connected PS5 controllers"""
         pygame.joystick.quit()
@@ -120,42 +459,14 @@ class DriverStation:
         while self.running:
             try:
                 # Listen for discovery packets
-                data, addr = self.udp_socket.recvfrom(1024)
+                data, addr, rx_time = self._receive()
                 message = data.decode('utf-8', errors='ignore')
 
                 # Debug: Print ALL received packets
                 print(f"[DEBUG] Received packet from {addr}: {message[:50]}")
 
-                # Parse discovery message: "DISCOVER:<robotId>:<IP>" or "DISCOVER:<robotId>:<IP>:<port>"
-                if message.startswith("DISCOVER:"):
-                    parts = message.split(":")
-                    if len(parts) >= 3:
-                        robot_id = parts[1]
-                        robot_ip = parts[2]
-                        # Check if discovery includes a port (for demo mode)
-                        discovery_port = int(parts[3]) if len(parts) >= 4 else DISCOVERY_PORT
-
-                        if robot_id not in self.robots:
-                            # Assign a port for this robot
-                            port = COMMAND_PORT_BASE + len(self.robots)
-                            self.robots[robot_id] = RobotInfo(
-                                robot_id=robot_id,
-                                ip=robot_ip,
-                                port=port,
-                                last_seen=time.time(),
-                                connected=False
-                            )
-                            print(f"Discovered robot: {robot_id} at {robot_ip}:{discovery_port}")
-                        else:
-                            # Update last seen time
-                            self.robots[robot_id].last_seen = time.time()
-
-                        # Send port assignment to the discovery port
-                        robot_info = self.robots[robot_id]
-                        response = f"PORT:{robot_id}:{robot_info.port}"
-                        self.udp_socket.sendto(response.encode(), (robot_ip, discovery_port))
-                        robot_info.connected = True
-                        
+                self._handle_packet(message, rx_time)
+
             except socket.timeout:
                 pass
             except Exception as e:
@@ -169,12 +480,229 @@ class DriverStation:
             ]
             for robot_id in stale_robots:
                 print(f"Robot {robot_id} timed out")
+                self.m_discovery.labels('timeout').inc()
                 del self.robots[robot_id]
+                self._drop_robot_metrics(robot_id)
                 if robot_id in self.robot_controller_pairs:
                     del self.robot_controller_pairs[robot_id]
             
             time.sleep(0.05)
     
+    def _handle_packet(self, message: str, rx_time: float):
+        """Dispatch one packet from the discovery socket"""
+        # Parse discovery message: "DISCOVER:<robotId>:<IP>[:<reply port>[:shared=<port>]]"
+        if message.startswith("DISCOVER:"):
+            self.m_packets_rx.labels('discover').inc()
+            parts = message.split(":")
+            if len(parts) >= 3:
+                robot_id = parts[1]
+                robot_ip = parts[2]
+                # Check if discovery includes a port (for demo mode)
+                discovery_port = int(parts[3]) if len(parts) >= 4 else DISCOVERY_PORT
+
+                # Robots hosted on one ESP32 share its socket. Once one of
+                # them is connected, the others advertise that command port.
+                advertised = None
+                for field in parts[4:]:
+                    if field.startswith("shared="):
+                        advertised = int(field[len("shared="):])
+                shared_port = self._shared_port(robot_ip, advertised)
+
+                if robot_id not in self.robots:
+                    # Assign a port for this robot
+                    port = shared_port or self._next_free_port()
+                    self.robots[robot_id] = RobotInfo(
+                        robot_id=robot_id,
+                        ip=robot_ip,
+                        port=port,
+                        last_seen=time.time(),
+                        connected=False
+                    )
+                    print(f"Discovered robot: {robot_id} at {robot_ip}:{discovery_port}")
+                    self.m_discovery.labels('new').inc()
+                else:
+                    # Update last seen time
+                    self.robots[robot_id].last_seen = time.time()
+                    self.m_discovery.labels('refresh').inc()
+                    if shared_port:
+                        self.robots[robot_id].port = shared_port
+
+                # Send port assignment to the discovery port
+                robot_info = self.robots[robot_id]
+                response = f"PORT:{robot_id}:{robot_info.port}"
+                self.udp_socket.sendto(response.encode(), (robot_ip, discovery_port))
+                robot_info.connected = True
+
+        # Parse telemetry: "TELEM:<robotId>:<key>=<value>,..."
+        elif message.startswith("TELEM:"):
+            self.m_packets_rx.labels('telemetry').inc()
+            parts = message.split(":", 2)
+            if len(parts) == 3 and parts[1] in self.robots:
+                self._handle_telemetry(self.robots[parts[1]], parts[2], rx_time)
+
+        # Channel survey: "SURVEY:<robotId>:ap=<ch>,...,c<ch>=<nets>/<rssi>/<busy permille>/<frames>,..."
+        elif message.startswith("SURVEY:"):
+            self.m_packets_rx.labels('survey').inc()
+            parts = message.split(":", 2)
+            if len(parts) == 3:
+                self._handle_survey(parts[1], parts[2])
+
+        else:
+            self.m_packets_rx.labels('other').inc()
+
+    def _shared_port(self, robot_ip: str, advertised: Optional[int]) -> Optional[int]:
+        """advertised, if it is the command port of another robot on the same board"""
+        if advertised is None:
+            return None
+        for info in list(self.robots.values()):
+            if info.ip == robot_ip and info.port == advertised:
+                return advertised
+        return None
+
+    def _next_free_port(self) -> int:
+        """Lowest command port not already assigned"""
+        used = {info.port for info in list(self.robots.values())}
+        port = COMMAND_PORT_BASE
+        while port in used:
+            port += 1
+        return port
+
+    def _handle_telemetry(self, robot_info: RobotInfo, payload: str, rx_time: float):
+        """Store the key=value counters a robot reports once a second.
+        rx_time is the report's arrival in time.monotonic() seconds."""
+        telemetry = {}
+        for item in payload.split(","):
+            key, sep, value = item.partition("=")
+            if sep:
+                try:
+                    telemetry[key] = int(value)
+                except ValueError:
+                    pass
+        robot_info.telemetry = telemetry
+        robot_info.last_seen = time.time()
+
+        robot_id = robot_info.robot_id
+        for key, value in telemetry.items():
+            self.m_telemetry.labels(robot_id, key).set(value)
+
+        # RTT: arrival - (send time of the newest frame the robot had) - how long it held it
+        rx_ms = rx_time * 1000.0
+        echo, hold = telemetry.get('echo', 0), telemetry.get('hold')
+        if echo and hold is not None and hold < 1000:
+            rtt_ms = (rx_ms - echo - hold + 0x80000000) % 0x100000000 - 0x80000000
+            # The robot's ms clock truncates, so a fast LAN can come out a hair negative
+            if -5 < rtt_ms < 10000:
+                rtt_ms = max(0.0, rtt_ms)
+                robot_info.rtt_ms = rtt_ms
+                self.m_rtt.labels(robot_id).observe(rtt_ms / 1000.0)
+
+                # Clock offset: the report left the robot at t, about rtt/2 before
+                # it arrived. Trust the lowest-RTT sample of the last few.
+                robot_ms = telemetry.get('t')
+                if robot_ms is not None:
+                    offset = (robot_ms - (rx_ms - rtt_ms / 2)) % 0x100000000
+                    if offset >= 0x80000000:
+                        offset -= 0x100000000
+                    samples = robot_info.sync_samples
+                    samples.append((rtt_ms, offset))
+                    del samples[:-CLOCK_SYNC_SAMPLES]
+                    robot_info.clock_offset_ms = min(samples)[1]
+                    self.m_clock_offset.labels(robot_id).set(robot_info.clock_offset_ms / 1000.0)
+
+        # Loss: frames sent vs frames the robot counted since the last report
+        rx = telemetry.get('rx')
+        if rx is not None:
+            sent = robot_info.frames_sent
+            if robot_info.loss_mark is not None:
+                sent_delta = sent - robot_info.loss_mark[0]
+                rx_delta = rx - robot_info.loss_mark[1]
+                if sent_delta > 0 and rx_delta >= 0:
+                    robot_info.loss = max(0.0, 1.0 - rx_delta / sent_delta)
+                    self.m_loss.labels(robot_id).set(robot_info.loss)
+            robot_info.loss_mark = (sent, rx)
+
+    def _request_survey(self):
+        """Ask every robot board to survey the channels (between matches only)"""
+        if self.game_status != "standby":
+            print("Channel survey only runs in standby (robots leave the AP for a few seconds)")
+            return
+        # Robots on one ESP32 share the radio; one request per board
+        boards = {}
+        for robot_info in list(self.robots.values()):
+            if robot_info.connected:
+                boards.setdefault(robot_info.ip, robot_info)
+        for robot_info in boards.values():
+            try:
+                self.udp_socket.sendto(b"SURVEY", (robot_info.ip, robot_info.port))
+            except Exception as e:
+                print(f"Error requesting survey: {e}")
+        print(f"Channel survey requested from {len(boards)} board(s)")
+
+    def _handle_survey(self, robot_id: str, payload: str):
+        """Store one board's SURVEY report and update the recommendation"""
+        report = ChannelSurveyReport(robot_id=robot_id, received=time.time(), ap_channel=0, off_air_ms=0)
+        for item in payload.split(","):
+            key, sep, value = item.partition("=")
+            if not sep:
+                continue
+            try:
+                if key == "ap":
+                    report.ap_channel = int(value)
+                elif key == "off":
+                    report.off_air_ms = int(value)
+                elif key.startswith("c") and key[1:].isdigit():
+                    networks, rssi, busy, frames = (int(v) for v in value.split("/"))
+                    report.channels[int(key[1:])] = (networks, rssi, busy / 1000.0, frames)
+            except ValueError:
+                pass
+        if not report.channels:
+            return
+        self.surveys[robot_id] = report
+
+        for channel, (networks, _rssi, busy, _frames) in report.channels.items():
+            self.m_channel_busy.labels(robot_id, str(channel)).set(busy)
+            self.m_channel_networks.labels(robot_id, str(channel)).set(networks)
+
+        print(f"Channel survey from {robot_id} (AP on {report.ap_channel}, "
+              f"{report.off_air_ms} ms off the air):")
+        for channel, (networks, rssi, busy, frames) in sorted(report.channels.items()):
+            loudest = f"{rssi} dBm" if networks else "-"
+            print(f"  ch {channel:2}: {busy:6.1%} busy  {frames:5} frames  {networks:3} networks  {loudest}")
+
+        self.recommended_channel = self._recommend_channel()
+        if self.recommended_channel:
+            channel, load = self.recommended_channel
+            print(f"Recommended channel: {channel} (load {load:.1%} across {len(self.surveys)} board(s))")
+
+    @staticmethod
+    def _channel_load(report: ChannelSurveyReport, channel: int) -> float:
+        """Expected contention on channel: airtime and networks heard on it and
+        its neighbours, weighted by how much their 22 MHz masks overlap"""
+        load = 0.0
+        for other, (networks, _rssi, busy, _frames) in report.channels.items():
+            overlap = 1.0 - abs(other - channel) * 5 / 22
+            if overlap > 0:
+                load += overlap * (busy + SURVEY_NETWORK_COST * networks)
+        return load
+
+    def _recommend_channel(self) -> Optional[Tuple[int, float]]:
+        """(channel, load) with the lowest fleet-average load, or None.
+        Each board hears the band from a different spot; ties go to the
+        channel whose worst board is least loaded."""
+        now = time.time()
+        reports = [r for r in self.surveys.values() if now - r.received < SURVEY_MAX_AGE]
+        if not reports:
+            return None
+        best = None
+        for channel in SURVEY_CANDIDATES:
+            loads = [self._channel_load(r, channel) for r in reports if channel in r.channels]
+            if not loads:
+                continue
+            key = (sum(loads) / len(loads), max(loads))
+            if best is None or key < best[1]:
+                best = (channel, key)
+        return (best[0], best[1][0]) if best else None
+
     def _send_controller_data(self, robot_id: str, controller: ControllerState):
         """Send controller data to robot in binary format"""
         if robot_id not in self.robots:
@@ -186,7 +714,7 @@ class DriverStation:
         
         # Only send controller data in teleop mode
         if self.game_status == "teleop" and not self.emergency_stop:
-            # Create binary packet (24 bytes)
+            # Create binary packet (30 bytes)
             # Bytes 0-15: Robot name (16 bytes, null-terminated)
             robot_name_bytes = robot_id.encode('utf-8')[:15].ljust(16, b'\x00')
             
@@ -201,21 +729,33 @@ class DriverStation:
             )
             
             # Bytes 22-23: Button data (2 bytes)
-            button_byte_0 = (
-                (1 if controller.cross else 0) |
-                ((1 if controller.circle else 0) << 1) |
-                ((1 if controller.square else 0) << 2) |
-                ((1 if controller.triangle else 0) << 3)
-            )
-            buttons = struct.pack('BB', button_byte_0, 0)
-            
-            packet = robot_name_bytes + axes + buttons
+            buttons = struct.pack('BB', self._button_byte(controller), 0)
+
+            # Bytes 24-29: Sequence number and send time in ms (little-endian),
+            # used by the robot's playout buffer and for latency reporting
+            robot_info.tx_seq = (robot_info.tx_seq + 1) & 0xFFFF
+            stamp = struct.pack('<HI', robot_info.tx_seq, int(time.monotonic() * 1000) & 0xFFFFFFFF)
+
+            packet = robot_name_bytes + axes + buttons + stamp
             
             try:
                 self.udp_socket.sendto(packet, (robot_info.ip, robot_info.port))
+                robot_info.frames_sent += 1
+                self.m_frames_sent.labels(robot_id).inc()
             except Exception as e:
+                self.m_send_errors.inc()
                 print(f"Error sending controller data: {e}")
     
+    @staticmethod
+    def _button_byte(controller: ControllerState) -> int:
+        """Button bitfield for byte 22 of the controller frame"""
+        return (
+            (1 if controller.cross else 0) |
+            ((1 if controller.circle else 0) << 1) |
+            ((1 if controller.square else 0) << 2) |
+            ((1 if controller.triangle else 0) << 3)
+        )
+
     def _send_game_status(self, robot_id: str):
         """Send game status to robot"""
         if robot_id not in self.robots:
@@ -243,7 +783,9 @@ class DriverStation:
     
     def _update_controllers(self):
         """Update controller states from pygame events"""
-        for event in pygame.event.get():
+        events = pygame.event.get()
+        self.m_event_queue.set(len(events))
+        for event in events:
             if event.type == pygame.QUIT:
                 self.running = False
             
@@ -286,6 +828,10 @@ class DriverStation:
                     for robot_id in self.robots:
                         self._send_game_status(robot_id)
                     print("Game status: autonomous")
+                elif event.key == pygame.K_s:
+                    self._request_survey()
+                elif event.key == pygame.K_p:
+                    self._toggle_profiler()
             
             elif event.type == pygame.MOUSEBUTTONDOWN:
                 self._handle_mouse_click(event.pos)
@@ -304,9 +850,34 @@ class DriverStation:
                 controller.right_x = max(0, min(255, right_x))
                 controller.right_y = max(0, min(255, right_y))
     
+    def _toggle_profiler(self):
+        """Start sampling, or stop and write the profile as folded stacks"""
+        if not self.profiler.running:
+            self.profiler.start()
+            print(f"Profiler on ({1 / self.profiler.interval:.0f} Hz), P or SIGUSR1 again to stop")
+            return
+        self.profiler.stop()
+        for subsystem, count in self.profiler.by_subsystem.items():
+            self.m_profile_samples.labels(subsystem).inc(count)
+        path = os.path.join(self.profile_dir, datetime.now().strftime("profile-%Y%m%d-%H%M%S.folded"))
+        try:
+            os.makedirs(self.profile_dir, exist_ok=True)
+            self.profiler.write_folded(path)
+            print(f"Profile written to {path} (flamegraph.pl {path} > profile.svg)")
+        except OSError as e:
+            print(f"Could not write profile: {e}")
+        print(self.profiler.summary())
+
+    def _drop_robot_metrics(self, robot_id: str):
+        """Remove a robot's series from every per-robot metric family"""
+        for family in self.m_per_robot:
+            family.remove(robot_id)
+
     def _refresh_robots(self):
         """Clear robot list and force rediscovery"""
         print("Refreshing robot list...")
+        for robot_id in list(self.robots):
+            self._drop_robot_metrics(robot_id)
         self.robots.clear()
         self.robot_controller_pairs.clear()
         self.selected_robot = None
@@ -405,6 +976,21 @@ class DriverStation:
             self.screen.blit(ip_text, (60, robot_y + 35))
             self.screen.blit(port_text, (60, robot_y + 55))
             self.screen.blit(status_text, (300, robot_y + 10))
+
+            # Playout buffer telemetry
+            telemetry = robot_info.telemetry
+            if telemetry:
+                buffer_text = self.font.render(
+                    f"Buffer: {telemetry.get('jb', 0)} @ {telemetry.get('jbd', 0)}ms  Late: {telemetry.get('late', 0)}",
+                    True, GRAY
+                )
+                self.screen.blit(buffer_text, (300, robot_y + 35))
+
+                link_text = self.font.render(
+                    f"Link drops: {telemetry.get('lnk', 0)}  Max outage: {telemetry.get('outmax', 0)}ms",
+                    True, RED if telemetry.get('lnk', 0) else GRAY
+                )
+                self.screen.blit(link_text, (300, robot_y + 55))
             
             robot_y += 130
         
@@ -458,7 +1044,7 @@ class DriverStation:
         instructions = [
             "Controls:",
             "1: Standby | 2: Teleop | 3: Autonomous",
-            "SPACE: Emergency Stop",
+            "SPACE: Emergency Stop | S: Channel survey (standby) | P: Profiler",
             "Click robot and controller, then PAIR button",
             "ESC: Quit"
         ]
@@ -468,6 +1054,21 @@ class DriverStation:
             text = self.font.render(instruction, True, GRAY)
             self.screen.blit(text, (50, y_offset))
             y_offset += 25
+
+        # Channel survey result
+        if self.recommended_channel:
+            channel, load = self.recommended_channel
+            ap_channels = sorted({r.ap_channel for r in self.surveys.values() if r.ap_channel})
+            lines = [
+                (f"Channel survey ({len(self.surveys)} board(s)):", WHITE),
+                (f"Recommended channel {channel} (load {load:.0%})", GREEN),
+                (f"AP currently on {', '.join(map(str, ap_channels)) or '?'}", GRAY),
+            ]
+            y_offset = 580
+            for line, color in lines:
+                text = self.font.render(line, True, color)
+                self.screen.blit(text, (650, y_offset))
+                y_offset += 25
         
         pygame.display.flip()
     
@@ -479,22 +1080,55 @@ class DriverStation:
         print("  2 - Set to Teleop mode")
         print("  3 - Set to Autonomous mode")
         print("  SPACE - Toggle Emergency Stop")
+        print("  S - Channel survey (standby only)")
+        print("  P - Start/stop the sampling profiler (or SIGUSR1)")
         print("  ESC - Quit")
+        if self.realtime and self.tx is None:
+            self._enter_realtime()  # after the helper threads started; see there
         
+        frame_time = 1.0 / FPS
+        last_tick = time.perf_counter()
+        jitter = 0.0
+        frames = 0
+
         while self.running:
+            tick = time.perf_counter()
+            interval = tick - last_tick
+            last_tick = tick
+            self.m_tick_interval.observe(interval)
+            jitter += (abs(interval - frame_time) - jitter) / 16
+            self.m_send_jitter.set(jitter)
+
             self._update_controllers()
+            if self.profile_toggle:
+                self.profile_toggle = False
+                self._toggle_profiler()
             
             # Send controller data to paired robots
-            for robot_id, controller_index in self.robot_controller_pairs.items():
-                if controller_index in self.controllers and robot_id in self.robots:
-                    controller = self.controllers[controller_index]
-                    self._send_controller_data(robot_id, controller)
+            if self.tx is not None:
+                self._sync_native_tx()
+            else:
+                for robot_id, controller_index in self.robot_controller_pairs.items():
+                    if controller_index in self.controllers and robot_id in self.robots:
+                        controller = self.controllers[controller_index]
+                        self._send_controller_data(robot_id, controller)
+                frames += 1
+                if self.manual_gc and frames % FPS == 0:
+                    self._collect_garbage(frames // FPS)
             
+            render_start = time.perf_counter()
             self._draw_ui()
+            self.m_render.observe(time.perf_counter() - render_start)
             self.clock.tick(FPS)
         
         # Cleanup
         print("Shutting down driver station...")
+        if self.profiler.running:
+            self._toggle_profiler()
+        if self.tx is not None:
+            self.tx.stop()
+            if self.tx_socket is not None:
+                self.tx_socket.close()
         self.emergency_stop = True
         self._send_emergency_stop(True)
         time.sleep(0.5)
@@ -502,8 +1136,52 @@ class DriverStation:
         pygame.quit()
 
 def main():
+    parser = argparse.ArgumentParser(description="Minibot Driver Station")
+    parser.add_argument("--metrics-port", type=int, default=None,
+                        help="serve Prometheus metrics on http://127.0.0.1:<port>/metrics")
+    parser.add_argument("--metrics-file", default=None,
+                        help="write Prometheus metrics to this file periodically (textfile collector)")
+    parser.add_argument("--metrics-interval", type=float, default=5.0,
+                        help="seconds between metrics file writes (default 5)")
+    parser.add_argument("--no-native-tx", action="store_true",
+                        help="send controller frames from Python even if native/station_tx is built")
+    parser.add_argument("--tx-pacing", choices=("batch", "soft", "txtime"), default="batch",
+                        help="native core: all frames at the tick (batch), or spread across it, "
+                             "timed by the transmit thread (soft) or by the kernel via SO_TXTIME (txtime)")
+    parser.add_argument("--txtime-clock", choices=("tai", "monotonic"), default="tai",
+                        help="SO_TXTIME clock: tai for the ETF qdisc, monotonic for fq")
+    parser.add_argument("--txtime-lead-us", type=float, default=1000.0,
+                        help="how far ahead of its launch time each txtime frame is queued")
+    parser.add_argument("--realtime", action="store_true",
+                        help="pin the transmit path to its own CPU, run it SCHED_FIFO and lock memory "
+                             "(check the machine first with check_rt.py)")
+    parser.add_argument("--rt-cpu", type=int, default=None,
+                        help="CPU for the transmit path in --realtime mode (default: the last one)")
+    parser.add_argument("--rt-priority", type=int, default=RT_PRIORITY,
+                        help=f"SCHED_FIFO priority in --realtime mode (default {RT_PRIORITY})")
+    parser.add_argument("--profile", action="store_true",
+                        help="start the sampling profiler at launch (P or SIGUSR1 toggles it later)")
+    parser.add_argument("--profile-hz", type=float, default=PROFILE_HZ,
+                        help=f"profiler samples per second (default {PROFILE_HZ})")
+    parser.add_argument("--profile-dir", default=".",
+                        help="directory for profile-<time>.folded files (default: current)")
+    args = parser.parse_args()
+
     try:
-        station = DriverStation()
+        station = DriverStation(native_tx=not args.no_native_tx, tx_pacing=args.tx_pacing,
+                                txtime_clock=args.txtime_clock, txtime_lead_us=args.txtime_lead_us,
+                                realtime=args.realtime, rt_cpu=args.rt_cpu, rt_priority=args.rt_priority,
+                                profile_hz=args.profile_hz, profile_dir=args.profile_dir)
+        if args.metrics_port:
+            start_http_server(station.metrics, args.metrics_port)
+            print(f"Metrics at http://127.0.0.1:{args.metrics_port}/metrics")
+        if args.metrics_file:
+            start_textfile_writer(station.metrics, args.metrics_file, args.metrics_interval)
+            print(f"Writing metrics to {args.metrics_file}")
+        if hasattr(signal, 'SIGUSR1'):  # kill -USR1 <pid> toggles the profiler, e.g. from an SSH session
+            signal.signal(signal.SIGUSR1, lambda signum, frame: setattr(station, 'profile_toggle', True))
+        if args.profile:
+            station._toggle_profiler()
         station.run()
     except Exception as e:
         print(f"Error: {e}")
@@ -0,0 +1,57 @@
+/*
+ * MINIBOT - ESP-IDF version of minibots.ino (tank drive)
+ * Same Minibot API, built without the Arduino core. See ESP_IDF.md.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "minibot.h"
+
+// ============ CONFIGURATION ============
+
+#define ROBOT_NAME "testingDas"
+#define LEFT_MOTOR_PIN   18
+#define RIGHT_MOTOR_PIN  19
+
+#define DEADZONE 10
+#define MOTOR_REVERSE_LEFT  false
+#define MOTOR_REVERSE_RIGHT false
+#define MAX_SPEED 1.0f
+#define USE_PLAYOUT_BUFFER false
+
+// ============ END CONFIGURATION ============
+
+static float applyDeadzone(uint8_t value) {
+    float scaled = (value - 127.5f) / 127.5f;
+    if (scaled > -(DEADZONE / 127.5f) && scaled < (DEADZONE / 127.5f)) {
+        return 0.0f;
+    }
+    scaled *= MAX_SPEED;
+    return scaled < -1.0f ? -1.0f : scaled > 1.0f ? 1.0f : scaled;
+}
+
+extern "C" void app_main(void) {
+    // Constructed here rather than as a global: global constructors run
+    // before the scheduler starts, and Minibot waits for WiFi in its own
+    static Minibot bot(ROBOT_NAME, LEFT_MOTOR_PIN, RIGHT_MOTOR_PIN);
+    bot.enablePlayoutBuffer(USE_PLAYOUT_BUFFER);
+
+    while (true) {
+        bot.updateController();
+
+        if (bot.isTeleop()) {
+            float leftSpeed = -applyDeadzone(bot.getLeftY());
+            float rightSpeed = -applyDeadzone(bot.getRightY());
+            if (MOTOR_REVERSE_LEFT) leftSpeed = -leftSpeed;
+            if (MOTOR_REVERSE_RIGHT) rightSpeed = -rightSpeed;
+            bot.driveLeft(leftSpeed);
+            bot.driveRight(rightSpeed);
+        } else {
+            bot.driveLeft(0);
+            bot.driveRight(0);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
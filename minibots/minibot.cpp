@@ -1,41 +1,75 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "minibot.h"
 
-// PWM channels (0-7 for low speed mode)
-#define LEFT_MOTOR_CHANNEL  LEDC_CHANNEL_0
-#define RIGHT_MOTOR_CHANNEL LEDC_CHANNEL_1
+// PWM channels (0-7 for low speed mode), two per robot in declaration order
 #define PWM_TIMER           LEDC_TIMER_0
 #define PWM_SPEED_MODE      LEDC_LOW_SPEED_MODE
+#define NO_CHANNEL          0xFF
+
+// Pulses start somewhere in [0, PWM_PHASE_SPAN) so the longest pulse still
+// ends inside the period and never wraps into the next one.
+#define PWM_PERIOD_COUNTS   (1UL << PWM_RES)
+#define PWM_PHASE_SPAN      (PWM_PERIOD_COUNTS - \
+                             (uint32_t)(PWM_MAX_PULSE_MS / (1000.0 / PWM_FREQ) * PWM_PERIOD_COUNTS))
+
+MinibotLink& Minibot::link() {
+    // Function-local so it exists before any global Minibot is constructed
+    static MinibotLink shared;
+    return shared;
+}
 
 Minibot::Minibot(const char* id, uint8_t l, uint8_t r)
-    : robotId(id), leftPin(l), rightPin(r),
-      leftChannel(LEFT_MOTOR_CHANNEL), rightChannel(RIGHT_MOTOR_CHANNEL),
+    : robotId(id), idLen(strlen(id)), leftPin(l), rightPin(r),
+      leftChannel(NO_CHANNEL), rightChannel(NO_CHANNEL),
       leftX(127), leftY(127), rightX(127), rightY(127),
-      buttons(0), gameStatus(0), emergencyStop(false), connected(false),
-      assignedPort(0), lastPingTime(0), lastCommandTime(0)
+      buttons(0), gameStatus(0), connected(false),
+      assignedPort(0), lastPingTime(0), lastCommandTime(0),
+      stationIP(0), lastTelemetryTime(0), framesReceived(0), lastSeq(0), lastStamp(0), lastStampTime(0),
+      playoutEnabled(false), playoutHead(0), playoutCount(0),
+      haveApplied(false), lastAppliedSeq(0), transitValid(false),
+      transitBase(0), transitCandidate(0), transitFrames(0),
+      prevArrival(0), prevStamp(0), jitterQ4(0),
+      playoutDelay(PLAYOUT_MIN_DELAY_MS), lateRun(0), lateDrops(0), pendingLen(0)
 {
-    Serial.begin(115200);
-    delay(100);
-    Serial.println("\n=== Minibot Starting ===");
-    Serial.println("2-Motor Drive Configuration");
+    MinibotLink& shared = link();
+    bool first = (shared.robotCount == 0);
+
+    if(first) {
+        platform::begin();
+        platform::log("\n=== Minibot Starting (%s) ===", platform::name());
+
+        // 1. Configure PWM Timer (shared by every channel)
+        ledc_timer_config_t timer_conf;
+        timer_conf.speed_mode = PWM_SPEED_MODE;
+        timer_conf.timer_num = PWM_TIMER;
+        timer_conf.duty_resolution = (ledc_timer_bit_t)PWM_RES;
+        timer_conf.freq_hz = PWM_FREQ;
+        ledc_timer_config(&timer_conf);
+    }
+
+    platform::log("Robot: %s", robotId);
+    if(shared.robotCount >= MAX_ROBOTS || shared.nextChannel + 2 > LEDC_CHANNEL_MAX) {
+        platform::log("  Too many robots on this board, ignoring");
+        return;
+    }
+    leftChannel = shared.nextChannel++;
+    rightChannel = shared.nextChannel++;
+    shared.robots[shared.robotCount++] = this;
+
+    platform::log("2-Motor Drive Configuration");
 
     // Pin configuration
-    Serial.println("Pin configuration:");
-    Serial.print("  Left Motor:  GPIO"); Serial.println(leftPin);
-    Serial.print("  Right Motor: GPIO"); Serial.println(rightPin);
-
-    // 1. Configure PWM Timer
-    ledc_timer_config_t timer_conf;
-    timer_conf.speed_mode = PWM_SPEED_MODE;
-    timer_conf.timer_num = PWM_TIMER;
-    timer_conf.duty_resolution = (ledc_timer_bit_t)PWM_RES;
-    timer_conf.freq_hz = PWM_FREQ;
-    ledc_timer_config(&timer_conf);
+    platform::log("Pin configuration:");
+    platform::log("  Left Motor:  GPIO%u", leftPin);
+    platform::log("  Right Motor: GPIO%u", rightPin);
 
     // 2. Configure Left Motor Channel
     ledc_channel_config_t left_channel_conf;
     left_channel_conf.gpio_num = leftPin;
     left_channel_conf.speed_mode = PWM_SPEED_MODE;
-    left_channel_conf.channel = leftChannel;
+    left_channel_conf.channel = (ledc_channel_t)leftChannel;
     left_channel_conf.intr_type = LEDC_INTR_DISABLE;
     left_channel_conf.timer_sel = PWM_TIMER;
     left_channel_conf.duty = 0;
@@ -45,56 +79,218 @@ Minibot::Minibot(const char* id, uint8_t l, uint8_t r)
     // 3. Configure Right Motor Channel
     ledc_channel_config_t right_channel_conf = left_channel_conf; // Copy config
     right_channel_conf.gpio_num = rightPin;
-    right_channel_conf.channel = rightChannel;
+    right_channel_conf.channel = (ledc_channel_t)rightChannel;
     ledc_channel_config(&right_channel_conf);
 
-    Serial.println("PWM setup complete (using ESP-IDF).");
+    // 4. Spread every channel's rising edge across the period
+    staggerPhases();
 
-    // Connect to WiFi
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    Serial.print("WiFi connecting");
-    int attempts = 0;
-    while(WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
+    platform::log("PWM setup complete (using ESP-IDF).");
 
-    if(WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nConnected!");
-        Serial.print("IP: ");
-        Serial.println(WiFi.localIP());
-    } else {
-        Serial.println("\nFailed to connect!");
-        Serial.print("SSID: "); Serial.println(WIFI_SSID);
-        Serial.print("Password: "); Serial.println(WIFI_PASSWORD);
+    if(first) {
+        // Connect to WiFi. We rejoin ourselves on driver events rather than
+        // letting the driver retry on its own schedule.
+        platform::wifiBegin(WIFI_SSID, WIFI_PASSWORD, onLinkEvent);
+        platform::log("WiFi connecting...");
+        int attempts = 0;
+        while(!platform::wifiConnected() && attempts < 20) {
+            platform::delayMs(500);
+            attempts++;
+        }
+
+        shared.linkRestored = false;
+        shared.linkUp = platform::wifiConnected();
+        shared.localIP = platform::localIP();
+        if(shared.linkUp) {
+            char ip[16];
+            platform::formatIP(shared.localIP, ip, sizeof(ip));
+            platform::log("Connected! IP: %s", ip);
+        } else {
+            platform::log("Failed to connect!");
+            platform::log("SSID: %s", WIFI_SSID);
+            platform::log("Password: %s", WIFI_PASSWORD);
+        }
+
+        // Start UDP: the discovery port stays bound for good as the control
+        // socket; the data socket opens once a robot is paired
+        if(!platform::udpBindControl(DISCOVERY_PORT)) {
+            platform::log("UDP bind to port %u failed", (unsigned)DISCOVERY_PORT);
+        }
     }
 
-    // Start UDP
-    udp.begin(DISCOVERY_PORT);
     stopAllMotors();
-    Serial.println("Ready!");
+    shared.readyMs = (uint32_t)(platform::micros() / 1000);
+    platform::log("Ready! (%lu ms since boot, free heap %lu, min %lu)", (unsigned long)shared.readyMs,
+                  (unsigned long)platform::freeHeap(), (unsigned long)platform::minFreeHeap());
+}
+
+void Minibot::onLinkEvent(LinkEvent event, uint16_t reason) {
+    MinibotLink& shared = link();
+
+    switch(event) {
+    case LINK_DISCONNECTED:
+        // Leaves we caused ourselves (the survey, a rejoin starting from a
+        // link that's already down) aren't link problems
+        if(!shared.surveying && !(reason == LINK_REASON_ASSOC_LEAVE && !shared.linkUp)) countLinkReason(reason);
+        shared.linkRestored = false;
+        shared.rejoinDue = true;
+        // fall through
+    case LINK_LOST_IP:
+        if(event == LINK_LOST_IP) shared.ipLost++;
+        if(shared.linkUp) {
+            // Neutralize now; don't wait for the command timeout
+            shared.linkUp = false;
+            shared.linkDownSince = platform::millis();
+            shared.linkOutages++;
+            stopEveryMotor();
+        }
+        break;
+    case LINK_GOT_IP:
+        shared.linkRestored = true;
+        break;
+    }
+}
+
+void Minibot::countLinkReason(uint16_t reason) {
+    LinkReason* reasons = link().linkReasons;
+    for(int i = 0; i < LINK_REASON_SLOTS - 1; i++) {
+        if(reasons[i].count == 0) reasons[i].reason = reason;
+        if(reasons[i].reason == reason) {
+            reasons[i].count++;
+            return;
+        }
+    }
+    // Table full: the last slot is reserved for everything else (reason 0),
+    // so no real reason's history is ever relabelled
+    reasons[LINK_REASON_SLOTS - 1].reason = 0;
+    reasons[LINK_REASON_SLOTS - 1].count++;
+}
+
+void Minibot::serviceLink(uint32_t now) {
+    MinibotLink& shared = link();
+
+    if(shared.linkRestored) {
+        shared.linkRestored = false;
+        uint32_t ip = platform::localIP();
+        bool sameIP = (ip == shared.localIP);
+
+        if(shared.linkOutages > 0 && !shared.surveying) {
+            shared.lastOutageMs = now - shared.linkDownSince;
+            if(shared.lastOutageMs > shared.maxOutageMs) shared.maxOutageMs = shared.lastOutageMs;
+            shared.totalOutageMs += shared.lastOutageMs;
+        }
+
+        for(uint8_t i = 0; i < shared.robotCount; i++) {
+            Minibot* bot = shared.robots[i];
+            bot->playoutCount = 0;
+            bot->transitValid = false;
+            if(!bot->connected) continue;
+            if(sameIP) {
+                // Same address and the session hasn't timed out: the station
+                // is still sending to us, so just pick up where we left off.
+                bot->lastCommandTime = now;
+                bot->lastTelemetryTime = now - TELEMETRY_INTERVAL_MS;
+            } else {
+                bot->endSession();
+                bot->lastPingTime = now - 2001;
+            }
+        }
+
+        // Reopen the sockets, the data one on whatever port the sessions still use
+        platform::udpBindControl(DISCOVERY_PORT);
+        uint16_t port = shared.boundPort;
+        shared.boundPort = 0;
+        if(sameIP && port) bindPort(port);
+        platform::log(sameIP ? "Link resumed" : "Link back on new IP, rediscovering");
+
+        shared.localIP = ip;
+        shared.linkUp = true;
+        shared.rejoinDue = false;
+        shared.rejoinBackoffMs = 0;
+        shared.surveying = false;
+        if(shared.surveyReportDue) sendSurveyReport();
+        return;
+    }
+
+    if(shared.linkUp) return;
+
+    // Rejoin right away instead of waiting for the command timeout, but
+    // only with the radio idle (see WIFI_REJOIN_MIN_MS). A LOST_IP with
+    // the association intact is left to the DHCP client.
+    uint32_t since = now - shared.lastRejoinTime;
+    bool idle = shared.rejoinDue && since >= shared.rejoinBackoffMs;
+    bool stalled = !shared.rejoinDue && since >= WIFI_REJOIN_STALL_MS && platform::wifiChannel() == 0;
+    if(!idle && !stalled) return;
+
+    shared.rejoinDue = false;
+    shared.lastRejoinTime = now;
+    // The first attempt goes at once; each one that fails doubles the wait
+    shared.rejoinBackoffMs = shared.rejoinBackoffMs == 0 ? WIFI_REJOIN_MIN_MS
+                           : shared.rejoinBackoffMs >= WIFI_REJOIN_MAX_MS / 2 ? WIFI_REJOIN_MAX_MS
+                           : shared.rejoinBackoffMs * 2;
+    platform::wifiReconnect();
+}
+
+void Minibot::bindPort(uint16_t port) {
+    MinibotLink& shared = link();
+    if(shared.boundPort == port) return;
+    platform::udpClose();
+    if(port && !platform::udpBind(port)) platform::log("UDP bind to port %u failed", (unsigned)port);
+    shared.boundPort = port;
 }
 
 void Minibot::sendDiscoveryPing() {
-    char msg[64];
-    snprintf(msg, 64, "DISCOVER:%s:%s", robotId, WiFi.localIP().toString().c_str());
-    udp.beginPacket(IPAddress(255,255,255,255), DISCOVERY_PORT);
-    udp.write((uint8_t*)msg, strlen(msg));
-    udp.endPacket();
+    MinibotLink& shared = link();
+    char msg[64], ip[16];
+    platform::formatIP(platform::localIP(), ip, sizeof(ip));
+    if(shared.boundPort == 0) {
+        snprintf(msg, 64, "DISCOVER:%s:%s", robotId, ip);
+    } else {
+        // Another robot on this board holds the data socket on its command
+        // port; ask the station to command us there too. The 4th field stays
+        // the port to answer on (the control socket), as simulators use it.
+        snprintf(msg, 64, "DISCOVER:%s:%s:%u:shared=%u", robotId, ip,
+                 (unsigned)DISCOVERY_PORT, (unsigned)shared.boundPort);
+    }
+    platform::udpSend(PLATFORM_BROADCAST_IP, DISCOVERY_PORT, msg, strlen(msg));
 }
 
 void Minibot::stopAllMotors() {
+    if(leftChannel == NO_CHANNEL) return;
     // 1.5ms neutral pulse for 100Hz, 16-bit res -> duty cycle of 9830
     uint32_t neutral_duty = (uint32_t)((1.5 / 10.0) * (1 << PWM_RES));
-    ledc_set_duty(PWM_SPEED_MODE, leftChannel, neutral_duty);
-    ledc_update_duty(PWM_SPEED_MODE, leftChannel);
-    ledc_set_duty(PWM_SPEED_MODE, rightChannel, neutral_duty);
-    ledc_update_duty(PWM_SPEED_MODE, rightChannel);
+    ledc_set_duty(PWM_SPEED_MODE, (ledc_channel_t)leftChannel, neutral_duty);
+    ledc_update_duty(PWM_SPEED_MODE, (ledc_channel_t)leftChannel);
+    ledc_set_duty(PWM_SPEED_MODE, (ledc_channel_t)rightChannel, neutral_duty);
+    ledc_update_duty(PWM_SPEED_MODE, (ledc_channel_t)rightChannel);
+}
+
+void Minibot::staggerPhases() {
+    // All channels run off one timer, so with hpoint = 0 every pulse starts
+    // on the same count and the motors' inrush stacks up, dipping the
+    // supply under the radio. Offset channel i by i/n of the usable span.
+    // ledc_set_duty() leaves hpoint alone, so this only needs redoing when
+    // a channel is added.
+    uint8_t n = link().nextChannel;
+    for(uint8_t ch = 0; ch < n; ch++) {
+        uint32_t hpoint = (uint32_t)((uint64_t)PWM_PHASE_SPAN * ch / n);
+        uint32_t duty = ledc_get_duty(PWM_SPEED_MODE, (ledc_channel_t)ch);
+        ledc_set_duty_with_hpoint(PWM_SPEED_MODE, (ledc_channel_t)ch, duty, hpoint);
+        ledc_update_duty(PWM_SPEED_MODE, (ledc_channel_t)ch);
+    }
+}
+
+void Minibot::stopEveryMotor() {
+    MinibotLink& shared = link();
+    for(uint8_t i = 0; i < shared.robotCount; i++) {
+        shared.robots[i]->stopAllMotors();
+    }
 }
 
 void Minibot::writeMotor(uint8_t channel, float value) {
-    if(emergencyStop || value < -1.0 || value > 1.0) {
+    if(channel == NO_CHANNEL) return;
+    MinibotLink& shared = link();
+    if(shared.emergencyStop || !shared.linkUp || value < -1.0 || value > 1.0) {
         stopAllMotors();
         return;
     }
@@ -108,93 +304,484 @@ void Minibot::writeMotor(uint8_t channel, float value) {
 }
 
 void Minibot::updateController() {
-    uint32_t now = millis();
+    if(leftChannel == NO_CHANNEL) return;
+
+    MinibotLink& shared = link();
+    uint32_t now = platform::millis();
+
+    serviceLink(now);
 
     // Send discovery if not connected
-    if(!connected && (now - lastPingTime > 2000)) {
+    if(shared.linkUp && !connected && (now - lastPingTime > 2000)) {
         sendDiscoveryPing();
         lastPingTime = now;
     }
 
     // Check timeout
     if(connected && (now - lastCommandTime > 5000)) {
-        Serial.println("Timeout");
-        connected = false;
-        assignedPort = 0;
-        udp.stop();
-        udp.begin(DISCOVERY_PORT);
-        stopAllMotors();
+        platform::log("Timeout: %s", robotId);
+        endSession();
     }
 
-    // Check for packets
-    int len = udp.parsePacket();
-    if(!len) return;
-
-    len = udp.read(packet, 255);
-    if(len <= 0) return;
-    packet[len] = '\0';
-
-    // PORT assignment
-    if(!connected && strncmp(packet, "PORT:", 5) == 0) {
-        char* sep = strchr(packet + 5, ':');
-        if(sep) {
-            *sep = '\0';
-            if(strcmp(packet + 5, robotId) == 0) {
-                assignedPort = atoi(sep + 1);
-                if(assignedPort > 0) {
-                    udp.stop();
-                    udp.begin(assignedPort);
-                    connected = true;
-                    lastCommandTime = now;
-                    Serial.println("Connected: " + String(assignedPort));
-                }
-            }
+    receivePackets(now);
+
+    if(shared.surveyRequested) {
+        runSurvey();
+        return;
+    }
+
+    if(playoutEnabled) servicePlayout(now);
+
+    if(shared.linkUp && connected && (now - lastTelemetryTime >= TELEMETRY_INTERVAL_MS)) {
+        sendTelemetry();
+        lastTelemetryTime = now;
+    }
+}
+
+void Minibot::endSession() {
+    connected = false;
+    assignedPort = 0;
+    playoutCount = 0;
+    transitValid = false;
+    stopAllMotors();
+
+    // Close the data socket once no robot needs it; PORT replies come in
+    // on the control socket
+    MinibotLink& shared = link();
+    for(uint8_t i = 0; i < shared.robotCount; i++) {
+        if(shared.robots[i]->connected) return;
+    }
+    bindPort(0);
+}
+
+void Minibot::receivePackets(uint32_t now) {
+    MinibotLink& shared = link();
+
+    // The control socket first, so an ESTOP there is seen however busy the
+    // command port is (see MAX_CONTROL_PER_LOOP)
+    uint64_t start = platform::micros();
+    for(int i = 0; i < MAX_CONTROL_PER_LOOP; i++) {
+        int len = platform::udpReceiveControl(shared.packet, 255, &shared.packetFrom);
+        if(!len) break;
+        start = handleReceived(len, now, start);
+    }
+
+    // Then the command port: drain what queued up since the last loop,
+    // within a hard budget of packets and time so a flood can't starve the
+    // motors; what's left waits in the socket (and the stack drops the
+    // excess). Whichever robot's updateController() runs first does the
+    // work for all of them.
+    uint64_t loopStart = start;
+    bool cut = true;  // stopped by the budget rather than an empty socket
+    for(int i = 0; i < MAX_PACKETS_PER_LOOP && start - loopStart < RX_BUDGET_US; i++) {
+        int len = platform::udpReceive(shared.packet, 255, &shared.packetFrom);
+        if(!len) {
+            cut = false;
+            break;
+        }
+        start = handleReceived(len, now, start);
+    }
+    if(cut) shared.budgetHits++;
+
+    // Then each robot's newest control frame. Its cost joins the packet
+    // that brought it, as far as pktus is concerned.
+    for(uint8_t r = 0; r < shared.robotCount; r++) {
+        Minibot* bot = shared.robots[r];
+        if(!bot->pendingLen) continue;
+        uint64_t start = platform::micros();
+        int len = bot->pendingLen;
+        bot->pendingLen = 0;
+        memcpy(shared.packet, bot->pendingFrame, len);
+        shared.packet[len] = '\0';
+        bot->handlePacket(len, now);
+        shared.packetUsTotal += (uint32_t)(platform::micros() - start);
+    }
+}
+
+uint64_t Minibot::handleReceived(int len, uint32_t now, uint64_t start) {
+    // Dispatch the packet just read into packet[] and account for it from
+    // start; returns the end time, which is the next packet's start
+    MinibotLink& shared = link();
+    shared.packet[len] = '\0';
+
+    dispatchPacket(len, now);
+
+    uint64_t end = platform::micros();
+    uint32_t cost = (uint32_t)(end - start);
+    shared.packetsHandled++;
+    shared.packetUsTotal += cost;
+    if(cost > shared.packetUsMax) shared.packetUsMax = cost;
+    return end;
+}
+
+void Minibot::dispatchPacket(int len, uint32_t now) {
+    MinibotLink& shared = link();
+
+    // ESTOP stops the whole machine, whichever robot it came for. It and
+    // ESTOP_OFF are never rate limited.
+    if(strcmp(shared.packet, "ESTOP") == 0) {
+        shared.emergencyStop = true;
+        for(uint8_t r = 0; r < shared.robotCount; r++) {
+            shared.robots[r]->playoutCount = 0;
+            shared.robots[r]->pendingLen = 0;
+            shared.robots[r]->lastCommandTime = now;
         }
+        stopEveryMotor();
+        platform::log("ESTOP!");
         return;
     }
 
-    // ESTOP
-    if(strcmp(packet, "ESTOP") == 0) {
-        emergencyStop = true;
-        stopAllMotors();
-        lastCommandTime = now;
-        Serial.println("ESTOP!");
+    if(strcmp(shared.packet, "ESTOP_OFF") == 0) {
+        shared.emergencyStop = false;
+        for(uint8_t r = 0; r < shared.robotCount; r++) {
+            shared.robots[r]->lastCommandTime = now;
+        }
+        platform::log("ESTOP OFF");
+        return;
+    }
+
+    // Control frames: only the newest per robot gets applied, after the
+    // drain. Not with playout on: a clump of frames is exactly what the
+    // jitter buffer is there to smooth, so each stamped one goes to it.
+    Minibot* target = controlTarget(len);
+    if(target) {
+        if(target->playoutEnabled && len >= FRAME_STAMPED_LEN) target->handlePacket(len, now);
+        else target->holdFrame(len);
+        return;
+    }
+
+    // Everything else pays a token, so junk can't crowd out commands
+    if(isCommand()) {
+        if(!shared.commandBucket.take(now)) {
+            shared.commandDropped++;
+            return;
+        }
+    } else if(!shared.otherBucket.take(now)) {
+        shared.otherDropped++;
+        return;
+    }
+
+    // The survey takes the whole board off the air for a few seconds, so
+    // only between matches
+    if(strcmp(shared.packet, "SURVEY") == 0) {
+        for(uint8_t r = 0; r < shared.robotCount; r++) {
+            if(shared.robots[r]->gameStatus != 0) {
+                platform::log("Survey refused: %s is not in standby", shared.robots[r]->robotId);
+                return;
+            }
+        }
+        shared.surveyRequested = true;
+        shared.surveyFrom = shared.packetFrom;
         return;
     }
 
-    if(strcmp(packet, "ESTOP_OFF") == 0) {
-        emergencyStop = false;
+    for(uint8_t r = 0; r < shared.robotCount; r++) {
+        shared.robots[r]->handlePacket(len, now);
+    }
+}
+
+Minibot* Minibot::controlTarget(int len) {
+    // A binary frame carries the robot's name NUL-padded in bytes 0-15
+    if(len < FRAME_LEN) return nullptr;
+    MinibotLink& shared = link();
+    for(uint8_t r = 0; r < shared.robotCount; r++) {
+        Minibot* bot = shared.robots[r];
+        if(bot->idLen < 16 && shared.packet[bot->idLen] == '\0' &&
+           memcmp(shared.packet, bot->robotId, bot->idLen) == 0) return bot;
+    }
+    return nullptr;
+}
+
+bool Minibot::isCommand() {
+    MinibotLink& shared = link();
+    const char* packet = shared.packet;
+    if(strncmp(packet, "PORT:", 5) == 0 || strcmp(packet, "SURVEY") == 0) return true;
+    for(uint8_t r = 0; r < shared.robotCount; r++) {
+        Minibot* bot = shared.robots[r];
+        if(strncmp(packet, bot->robotId, bot->idLen) == 0 && packet[bot->idLen] == ':') return true;
+    }
+    return false;
+}
+
+void Minibot::holdFrame(int len) {
+    MinibotLink& shared = link();
+    const uint8_t* p = (const uint8_t*)shared.packet;
+    if(len > FRAME_STAMPED_LEN) len = FRAME_STAMPED_LEN;
+
+    if(pendingLen) {
+        shared.controlCoalesced++;
+        // It still arrived: keep rx honest for the station's loss figure
+        if(connected && !shared.emergencyStop && gameStatus == 1) framesReceived++;
+        // Keep whichever is newer; stamped frames say so themselves
+        if(pendingLen >= FRAME_STAMPED_LEN && len >= FRAME_STAMPED_LEN) {
+            uint16_t held = pendingFrame[24] | (pendingFrame[25] << 8);
+            uint16_t seq = p[24] | (p[25] << 8);
+            if((int16_t)(seq - held) <= 0) return;
+        }
+    }
+    memcpy(pendingFrame, p, len);
+    pendingLen = len;
+}
+
+void Minibot::runSurvey() {
+    MinibotLink& shared = link();
+    shared.surveyRequested = false;
+    if(!shared.linkUp) return;
+
+    platform::log("Channel survey: leaving the AP");
+    stopEveryMotor();
+    uint32_t start = platform::millis();
+    shared.surveyApChannel = platform::wifiChannel();
+    // Down before the driver says so, so onLinkEvent() doesn't count an outage
+    shared.surveying = true;
+    shared.linkUp = false;
+    shared.linkRestored = false;
+    shared.linkDownSince = start;
+
+    int n = platform::wifiSurvey(shared.survey, PLATFORM_MAX_CHANNELS, SURVEY_DWELL_MS);
+    shared.surveyCount = n > 0 ? n : 0;
+
+    // Rejoin here rather than from serviceLink(): nothing else can run
+    // meanwhile anyway. serviceLink() resumes the sessions on LINK_GOT_IP
+    // and sends the report.
+    platform::wifiReconnect();
+    shared.rejoinDue = false;  // our own leave; serviceLink() retries only if this attempt fails
+    shared.lastRejoinTime = platform::millis();
+    while(!platform::wifiConnected() && platform::millis() - start < SURVEY_REJOIN_MS) {
+        platform::delayMs(50);
+    }
+    if(!platform::wifiConnected()) {
+        // The AP didn't take us back in time: from here on this is an
+        // outage like any other, counted and retried by serviceLink()
+        shared.surveying = false;
+        shared.linkOutages++;
+        shared.linkDownSince = platform::millis();
+        platform::log("Channel survey: no rejoin after %u ms", (unsigned)SURVEY_REJOIN_MS);
+    }
+    shared.surveyOffAirMs = platform::millis() - start;
+    shared.surveyReportDue = true;
+    platform::log("Channel survey: %d channels, %lu ms off the air", n, (unsigned long)shared.surveyOffAirMs);
+}
+
+void Minibot::sendSurveyReport() {
+    MinibotLink& shared = link();
+    shared.surveyReportDue = false;
+
+    // One report per board, under its first robot's name
+    char msg[384];
+    int n = snprintf(msg, sizeof(msg), "SURVEY:%s:ap=%u,dwell=%u,off=%lu",
+        shared.robots[0]->robotId, (unsigned)shared.surveyApChannel, (unsigned)SURVEY_DWELL_MS,
+        (unsigned long)shared.surveyOffAirMs);
+    // c<channel>=<networks>/<strongest rssi>/<busy permille>/<frames>
+    for(int i = 0; i < shared.surveyCount && n > 0 && n < (int)sizeof(msg); i++) {
+        const ChannelSurvey& c = shared.survey[i];
+        n += snprintf(msg + n, sizeof(msg) - n, ",c%u=%u/%d/%u/%u", (unsigned)c.channel,
+                      (unsigned)c.networks, (int)c.strongestRssi, (unsigned)c.busyPermille, (unsigned)c.frames);
+    }
+    if(n <= 0) return;
+    if(n >= (int)sizeof(msg)) n = sizeof(msg) - 1;
+    platform::udpSend(shared.surveyFrom, DISCOVERY_PORT, msg, n);
+}
+
+void Minibot::handlePacket(int len, uint32_t now) {
+    MinibotLink& shared = link();
+    const char* packet = shared.packet;
+
+    // PORT assignment: "PORT:<robotId>:<port>"
+    if(strncmp(packet, "PORT:", 5) == 0) {
+        if(connected || strncmp(packet + 5, robotId, idLen) != 0 || packet[5 + idLen] != ':') return;
+
+        uint16_t port = atoi(packet + 6 + idLen);
+        if(port == 0) return;
+        if(shared.boundPort != 0 && shared.boundPort != port) {
+            // The socket is already serving another robot on a different port
+            platform::log("Port conflict, ignoring PORT for %s", robotId);
+            return;
+        }
+        assignedPort = port;
+        stationIP = shared.packetFrom;
+        bindPort(assignedPort);
+        connected = true;
         lastCommandTime = now;
-        Serial.println("ESTOP OFF");
+        platform::log("%s connected: %u", robotId, (unsigned)assignedPort);
         return;
     }
 
-    if(!connected || emergencyStop) return;
+    if(!connected || shared.emergencyStop) return;
 
     // Game status
-    if(strncmp(packet, robotId, strlen(robotId)) == 0 && packet[strlen(robotId)] == ':') {
-        char* status = packet + strlen(robotId) + 1;
+    if(strncmp(packet, robotId, idLen) == 0 && packet[idLen] == ':') {
+        const char* status = packet + idLen + 1;
         if(strcmp(status, "standby") == 0) gameStatus = 0;
         else if(strcmp(status, "teleop") == 0) gameStatus = 1;
         else if(strcmp(status, "autonomous") == 0) gameStatus = 2;
         lastCommandTime = now;
+        return;
     }
 
-    // Controller data (binary, 24 bytes)
-    if(len >= 24 && gameStatus == 1) {
+    // Controller data (binary, 24 bytes, or 30 with seq + timestamp)
+    if(len >= FRAME_LEN && gameStatus == 1) {
         char name[17];
         memcpy(name, packet, 16);
         name[16] = '\0';
 
         if(strcmp(name, robotId) == 0) {
-            leftX = packet[16];
-            leftY = packet[17];
-            rightX = packet[18];
-            rightY = packet[19];
-            buttons = packet[22];
+            const uint8_t* p = (const uint8_t*)packet;
+            ControlFrame f;
+            f.axes[0] = p[16];
+            f.axes[1] = p[17];
+            f.axes[2] = p[18];
+            f.axes[3] = p[19];
+            f.buttons = p[22];
+            f.seq = lastSeq + 1;
+            f.playoutTime = now;
             lastCommandTime = now;
+            framesReceived++;
+
+            if(len >= FRAME_STAMPED_LEN) {
+                uint32_t stamp = p[26] | (p[27] << 8) | (p[28] << 16) | ((uint32_t)p[29] << 24);
+                f.seq = p[24] | (p[25] << 8);
+                lastStamp = stamp;
+                lastStampTime = now;
+                if(playoutEnabled) {
+                    lastSeq = f.seq;
+                    queueFrame(f, stamp, now);
+                    return;
+                }
+            }
+            lastSeq = f.seq;
+            applyFrame(f);
+        }
+    }
+}
+
+void Minibot::applyFrame(const ControlFrame& f) {
+    leftX = f.axes[0];
+    leftY = f.axes[1];
+    rightX = f.axes[2];
+    rightY = f.axes[3];
+    buttons = f.buttons;
+    lastAppliedSeq = f.seq;
+    haveApplied = true;
+}
+
+void Minibot::queueFrame(ControlFrame& f, uint32_t stamp, uint32_t now) {
+    // Transit = arrival - send time, in a clock offset we never need to
+    // know; only its variation matters. The smallest transit seen in the
+    // window is the "fast path" every frame gets delayed relative to.
+    int32_t transit = (int32_t)(now - stamp);
+    if(!transitValid) {
+        transitBase = transitCandidate = transit;
+        transitFrames = 0;
+        transitValid = true;
+    } else {
+        int32_t d = (int32_t)(now - prevArrival) - (int32_t)(stamp - prevStamp);
+        if(d < 0) d = -d;
+        jitterQ4 += d - ((jitterQ4 + 8) >> 4);
+        if(transit < transitBase) transitBase = transit;
+        if(transit < transitCandidate) transitCandidate = transit;
+        if(++transitFrames >= PLAYOUT_BASE_WINDOW) {
+            // Let the base drift up if the path got slower (or clocks drift)
+            transitBase = transitCandidate;
+            transitCandidate = transit;
+            transitFrames = 0;
         }
     }
+    prevArrival = now;
+    prevStamp = stamp;
+
+    // Slew the delay toward ~3x jitter by 1 ms per frame so playout never jumps
+    uint32_t target = PLAYOUT_MIN_DELAY_MS + ((3 * jitterQ4) >> 4);
+    if(target > PLAYOUT_MAX_DELAY_MS) target = PLAYOUT_MAX_DELAY_MS;
+    if(playoutDelay < target) playoutDelay++;
+    else if(playoutDelay > target) playoutDelay--;
+
+    // Stale: something newer has already been played
+    if(haveApplied && (int16_t)(f.seq - lastAppliedSeq) <= 0) {
+        lateDrops++;
+        return;
+    }
+
+    f.playoutTime = stamp + transitBase + playoutDelay;
+    if((int32_t)(now - f.playoutTime) > 0) {
+        lateDrops++;
+        // A run of late frames means the path got slower for good; re-anchor
+        if(++lateRun >= PLAYOUT_MAX_LATE) {
+            transitValid = false;
+            lateRun = 0;
+        }
+        return;
+    }
+    lateRun = 0;
+
+    if(playoutCount == PLAYOUT_SLOTS) {
+        applyFrame(playout[playoutHead]);
+        playoutHead = (playoutHead + 1) % PLAYOUT_SLOTS;
+        playoutCount--;
+    }
+
+    // Insert in sequence order (the buffer is tiny, reordering is rare)
+    uint8_t i = playoutCount;
+    while(i > 0) {
+        ControlFrame& prev = playout[(playoutHead + i - 1) % PLAYOUT_SLOTS];
+        int16_t diff = (int16_t)(f.seq - prev.seq);
+        if(diff == 0) return;  // duplicate
+        if(diff > 0) break;
+        playout[(playoutHead + i) % PLAYOUT_SLOTS] = prev;
+        i--;
+    }
+    playout[(playoutHead + i) % PLAYOUT_SLOTS] = f;
+    playoutCount++;
+}
+
+void Minibot::servicePlayout(uint32_t now) {
+    while(playoutCount && (int32_t)(now - playout[playoutHead].playoutTime) >= 0) {
+        applyFrame(playout[playoutHead]);
+        playoutHead = (playoutHead + 1) % PLAYOUT_SLOTS;
+        playoutCount--;
+    }
+}
+
+void Minibot::enablePlayoutBuffer(bool enable) {
+    playoutEnabled = enable;
+    playoutCount = 0;
+    transitValid = false;
+    playoutDelay = PLAYOUT_MIN_DELAY_MS;
+}
+
+void Minibot::sendTelemetry() {
+    MinibotLink& shared = link();
+    // Fresh clock for the timing fields: the station derives RTT and our
+    // clock offset from them
+    uint32_t sendTime = platform::millis();
+    char msg[448];
+    int n = snprintf(msg, sizeof(msg),
+        "TELEM:%s:t=%lu,rx=%lu,seq=%u,echo=%lu,hold=%lu,jb=%u,jbd=%u,jit=%lu,late=%lu"
+        ",lnk=%lu,out=%lu,outmax=%lu,outsum=%lu,iplost=%lu"
+        ",boot=%lu,heap=%lu,heapmin=%lu,pkt=%lu,pktus=%lu,pktmax=%lu"
+        ",cctl=%lu,dcmd=%lu,doth=%lu,rxcut=%lu",
+        robotId, (unsigned long)sendTime, (unsigned long)framesReceived, (unsigned)lastSeq,
+        (unsigned long)lastStamp, (unsigned long)(sendTime - lastStampTime),
+        (unsigned)playoutCount, (unsigned)playoutDelay,
+        (unsigned long)(jitterQ4 >> 4), (unsigned long)lateDrops,
+        (unsigned long)shared.linkOutages, (unsigned long)shared.lastOutageMs,
+        (unsigned long)shared.maxOutageMs, (unsigned long)shared.totalOutageMs,
+        (unsigned long)shared.ipLost,
+        (unsigned long)shared.readyMs, (unsigned long)platform::freeHeap(),
+        (unsigned long)platform::minFreeHeap(), (unsigned long)shared.packetsHandled,
+        (unsigned long)(shared.packetsHandled ? shared.packetUsTotal / shared.packetsHandled : 0),
+        (unsigned long)shared.packetUsMax,
+        (unsigned long)shared.controlCoalesced, (unsigned long)shared.commandDropped,
+        (unsigned long)shared.otherDropped, (unsigned long)shared.budgetHits);
+    // Disconnect reason counts as r<reason>=<count>
+    for(int i = 0; i < LINK_REASON_SLOTS && n > 0 && n < (int)sizeof(msg); i++) {
+        const LinkReason& r = shared.linkReasons[i];
+        if(r.count == 0) continue;
+        n += snprintf(msg + n, sizeof(msg) - n, ",r%u=%u", (unsigned)r.reason, (unsigned)r.count);
+    }
+    if(n <= 0) return;
+    if(n >= (int)sizeof(msg)) n = sizeof(msg) - 1;
+    platform::udpSend(stationIP, DISCOVERY_PORT, msg, n);
 }
 
 void Minibot::driveLeft(float value) {
@@ -1,23 +1,163 @@
 #ifndef MINIBOT_H
 #define MINIBOT_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiUdp.h>
+#endif
+#include <stdint.h>
 #include <driver/ledc.h>
 
+#include "minibot_platform.h"
+
 // PWM settings
 #define PWM_FREQ 100
 #define PWM_RES 16
+#define PWM_MAX_PULSE_MS 2.0   // longest pulse writeMotor() produces
 
 // WiFi Configuration
 #define WIFI_SSID "RoboNet"
 #define WIFI_PASSWORD "robo8711"
 #define DISCOVERY_PORT 12345
 
+// Playout (jitter) buffer
+#define PLAYOUT_SLOTS        8     // queued control frames
+#define PLAYOUT_MIN_DELAY_MS 10    // never play out sooner than this
+#define PLAYOUT_MAX_DELAY_MS 80    // latency cap, even on a bad link
+#define PLAYOUT_BASE_WINDOW  256   // frames per transit-minimum window
+#define PLAYOUT_MAX_LATE     3     // consecutive late frames before re-anchoring
+
+// Link-loss handling
+// A rejoin attempt is only started once the radio is idle: after a
+// DISCONNECTED event, or when an attempt has gone silent and the radio
+// isn't associated. Starting one mid-association or mid-DHCP would tear
+// that attempt down. Failed attempts back off exponentially.
+#define WIFI_REJOIN_MIN_MS   500   // wait before retrying after the first failed attempt
+#define WIFI_REJOIN_MAX_MS   8000  // backoff cap
+#define WIFI_REJOIN_STALL_MS 15000 // an attempt with no event at all by then is retried
+#define LINK_REASON_SLOTS    6     // 5 distinct disconnect reasons + "everything else" (r0)
+#define LINK_REASON_ASSOC_LEAVE 8  // WIFI_REASON_ASSOC_LEAVE: we left (survey, rejoin)
+
+// Channel survey (standby only, on the station's SURVEY command)
+#define SURVEY_DWELL_MS      150   // promiscuous listen per channel
+#define SURVEY_REJOIN_MS     8000  // give up waiting for the AP after this
+
+// Logical robots hosted on one ESP32 (two LEDC channels each)
+#define MAX_ROBOTS 4
+
+// Telemetry
+#define TELEMETRY_INTERVAL_MS 1000
+
+// Receive-path overload protection, per board and updateController() call.
+// ESTOP/ESTOP_OFF always pass; control frames are coalesced to the newest
+// per robot (unless the playout buffer is on, which queues every one);
+// everything else spends a token from its class's bucket.
+// That only helps packets that get read: a flood on the command port fills
+// its socket's queue and the stack drops the rest, ESTOP included. So the
+// discovery port stays bound for good as a second, control socket (PORT
+// replies, broadcasts and the ESTOP the station sends there too), with a
+// queue of its own, and is drained first on every call.
+#define MAX_CONTROL_PER_LOOP  8     // control-socket packets read per call, outside the budget
+#define MAX_PACKETS_PER_LOOP  32    // command-port packets read per call
+#define RX_BUDGET_US          1000  // stop reading after this long
+#define RX_COMMAND_RATE       40    // PORT / game status / SURVEY, per second
+#define RX_COMMAND_BURST      16
+#define RX_OTHER_RATE         20    // anything unrecognised, per second
+#define RX_OTHER_BURST        8
+
+// Control frame layout (see ARCHITECTURE.md)
+#define FRAME_LEN        24    // name + axes + buttons
+#define FRAME_STAMPED_LEN 30   // + uint16 seq + uint32 station ms (little-endian)
+
+struct ControlFrame {
+    uint32_t playoutTime;  // local millis() at which to apply
+    uint16_t seq;
+    uint8_t axes[4];       // leftX, leftY, rightX, rightY
+    uint8_t buttons;
+};
+
+struct LinkReason {
+    uint16_t reason;   // wifi_err_reason_t, 0 = "everything else"
+    uint16_t count;
+};
+
+// Refills at rate tokens/s up to burst; each admitted packet takes one
+struct TokenBucket {
+    uint16_t rate, burst;
+    uint32_t milliTokens;  // tokens * 1000
+    uint32_t lastMs;
+
+    TokenBucket(uint16_t r, uint16_t b) : rate(r), burst(b), milliTokens(b * 1000UL), lastMs(0) {}
+
+    bool take(uint32_t now) {
+        uint32_t elapsed = now - lastMs;
+        if(elapsed > 60000) elapsed = 60000;  // full by then anyway; keeps the product in range
+        lastMs = now;
+        milliTokens += elapsed * rate;        // ms * tokens/s = milli-tokens
+        if(milliTokens > burst * 1000UL) milliTokens = burst * 1000UL;
+        if(milliTokens < 1000) return false;
+        milliTokens -= 1000;
+        return true;
+    }
+};
+
+class Minibot;
+
+// Everything one ESP32 has only one of: the radio, the UDP socket and the
+// receive loop. Every Minibot on the board shares it, and each received
+// packet is offered to the robot whose ID it carries.
+struct MinibotLink {
+    Minibot* robots[MAX_ROBOTS] = {};
+    uint8_t robotCount = 0;
+    uint8_t nextChannel = 0;
+
+    uint16_t boundPort = 0;    // data socket (a command port); 0 = closed, all traffic on the control socket
+    char packet[256];
+    uint32_t packetFrom = 0;   // sender of packet[]
+    bool emergencyStop = false;
+
+    // Written from the WiFi event task
+    volatile bool linkUp = false;
+    volatile bool linkRestored = false;
+    volatile uint32_t linkDownSince = 0;
+    volatile bool rejoinDue = false;   // a DISCONNECTED arrived: the radio is idle
+    uint32_t localIP = 0;
+    uint32_t lastRejoinTime = 0;
+    uint32_t rejoinBackoffMs = 0;      // 0 until an attempt fails
+    uint32_t linkOutages = 0, ipLost = 0;
+    uint32_t lastOutageMs = 0, maxOutageMs = 0, totalOutageMs = 0;
+    LinkReason linkReasons[LINK_REASON_SLOTS] = {};
+
+    // Measurement hooks, reported in telemetry
+    uint32_t readyMs = 0;          // boot to the last robot's "Ready!"
+    uint32_t packetsHandled = 0;
+    uint64_t packetUsTotal = 0;    // receive + dispatch time per packet
+    uint32_t packetUsMax = 0;
+
+    // Receive-path overload protection (see RX_* above)
+    TokenBucket commandBucket = TokenBucket(RX_COMMAND_RATE, RX_COMMAND_BURST);
+    TokenBucket otherBucket = TokenBucket(RX_OTHER_RATE, RX_OTHER_BURST);
+    uint32_t controlCoalesced = 0;  // frames superseded by a newer one in the same call (playout off)
+    uint32_t commandDropped = 0;
+    uint32_t otherDropped = 0;
+    uint32_t budgetHits = 0;        // calls that stopped reading with packets possibly left
+
+    // Channel survey: requested by packet, run from the loop, reported once
+    // the link is back. While surveying, the disconnect isn't an outage;
+    // failing to rejoin within SURVEY_REJOIN_MS is.
+    bool surveyRequested = false;
+    bool surveyReportDue = false;
+    volatile bool surveying = false;
+    uint32_t surveyFrom = 0;       // station that asked
+    uint32_t surveyOffAirMs = 0;   // leaving the AP to rejoining it
+    uint8_t surveyApChannel = 0;
+    uint8_t surveyCount = 0;
+    ChannelSurvey survey[PLATFORM_MAX_CHANNELS];
+};
+
 class Minibot {
 private:
     const char* robotId;
+    uint8_t idLen;
     uint8_t leftPin, rightPin;
     uint8_t leftChannel, rightChannel;
 
@@ -25,24 +165,79 @@ private:
     uint8_t buttons;  // bitfield
 
     uint8_t gameStatus;  // 0=standby, 1=teleop, 2=auto
-    bool emergencyStop;
     bool connected;
     uint16_t assignedPort;
     uint32_t lastPingTime;
     uint32_t lastCommandTime;
 
-    WiFiUDP udp;
-    char packet[256];
+    uint32_t stationIP;
+    uint32_t lastTelemetryTime;
+    uint32_t framesReceived;
+    uint16_t lastSeq;
+    uint32_t lastStamp;      // station timestamp of the newest frame
+    uint32_t lastStampTime;  // local time it arrived
+
+    // Playout buffer state
+    bool playoutEnabled;
+    ControlFrame playout[PLAYOUT_SLOTS];
+    uint8_t playoutHead, playoutCount;
+    bool haveApplied;
+    uint16_t lastAppliedSeq;
+    bool transitValid;
+    int32_t transitBase;     // min(arrival - stamp) over the last window
+    int32_t transitCandidate;
+    uint16_t transitFrames;
+    uint32_t prevArrival, prevStamp;
+    uint32_t jitterQ4;       // interarrival jitter in ms, <<4 (RFC 3550 style)
+    uint16_t playoutDelay;   // current adaptive delay in ms
+    uint8_t lateRun;
+    uint32_t lateDrops;
 
+    // Newest control frame received this call, applied after the drain
+    uint8_t pendingFrame[FRAME_STAMPED_LEN];
+    uint8_t pendingLen;
+
+    static MinibotLink& link();
+    static void onLinkEvent(LinkEvent event, uint16_t reason);
+    static void countLinkReason(uint16_t reason);
+    static void serviceLink(uint32_t now);
+    static void receivePackets(uint32_t now);
+    static uint64_t handleReceived(int len, uint32_t now, uint64_t start);
+    static void dispatchPacket(int len, uint32_t now);
+    static Minibot* controlTarget(int len);
+    static bool isCommand();
+    static void bindPort(uint16_t port);
+    static void stopEveryMotor();
+    static void staggerPhases();
+    static void runSurvey();
+    static void sendSurveyReport();
+
+    void handlePacket(int len, uint32_t now);
+    void holdFrame(int len);
+    void endSession();
+    void applyFrame(const ControlFrame& f);
+    void queueFrame(ControlFrame& f, uint32_t stamp, uint32_t now);
+    void servicePlayout(uint32_t now);
+    void sendTelemetry();
     void sendDiscoveryPing();
     void stopAllMotors();
     void writeMotor(uint8_t channel, float value);
 
 public:
+    // Several Minibots may be declared on one ESP32 (up to MAX_ROBOTS), each
+    // with its own ID, motors, pairing and mode. They share one socket.
     Minibot(const char* id, uint8_t l=16, uint8_t r=17);
 
+    // Call every loop for every Minibot on the board
     void updateController();
 
+    // Play control frames out at a constant, jitter-adaptive delay
+    // instead of applying them as they arrive. Off by default.
+    void enablePlayoutBuffer(bool enable = true);
+    inline uint8_t getPlayoutDepth() { return playoutCount; }
+    inline uint16_t getPlayoutDelay() { return playoutDelay; }
+    inline uint32_t getLateDrops() { return lateDrops; }
+
     // Getters
     inline uint8_t getLeftX() { return leftX; }
     inline uint8_t getLeftY() { return leftY; }
@@ -54,6 +249,9 @@ public:
     inline bool getSquare() { return buttons & 0x04; }
     inline bool getTriangle() { return buttons & 0x08; }
 
+    inline bool isLinkUp() { return link().linkUp; }
+    inline uint32_t getLinkOutages() { return link().linkOutages; }
+
     inline bool isTeleop() { return gameStatus == 1; }
     inline bool isAuto() { return gameStatus == 2; }
 
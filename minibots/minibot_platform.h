@@ -0,0 +1,85 @@
+#ifndef MINIBOT_PLATFORM_H
+#define MINIBOT_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Everything Minibot needs from the board besides LEDC (which it drives
+// through ESP-IDF directly on every build). One backend is compiled in:
+//   platform_arduino.cpp - Arduino core (WiFi, WiFiUDP, Serial)
+//   platform_idf.cpp     - plain ESP-IDF component (esp_wifi, lwIP sockets)
+//   platform_host.cpp    - desktop build for bench/ (simulated clock and link)
+// platform_survey.cpp adds the channel survey on both ESP32 backends.
+
+// Link changes reported by the WiFi driver. The handler may run on the
+// driver's event task, not the loop task.
+enum LinkEvent {
+    LINK_DISCONNECTED,  // reason = wifi_err_reason_t
+    LINK_LOST_IP,
+    LINK_GOT_IP
+};
+typedef void (*LinkEventHandler)(LinkEvent event, uint16_t reason);
+
+// IPv4 addresses are uint32_t in network byte order (lwIP's ip4_addr_t,
+// Arduino's IPAddress cast)
+#define PLATFORM_BROADCAST_IP 0xFFFFFFFFUL
+
+// One 2.4 GHz channel as seen by wifiSurvey()
+struct ChannelSurvey {
+    uint8_t channel;
+    uint8_t networks;       // APs heard in the passive scan
+    int8_t strongestRssi;   // dBm of the loudest of them, 0 if none
+    uint16_t busyPermille;  // airtime of the frames heard while listening, per 1000
+    uint16_t frames;        // frames heard while listening
+};
+#define PLATFORM_MAX_CHANNELS 14
+
+namespace platform {
+
+const char* name();
+void begin();                       // console; called once, before anything else
+void log(const char* fmt, ...) __attribute__((format(printf, 1, 2)));  // one line
+
+uint32_t millis();
+uint64_t micros();                  // since boot
+void delayMs(uint32_t ms);
+uint32_t freeHeap();
+uint32_t minFreeHeap();             // low-water mark since boot
+
+// Station mode, no automatic reconnect: Minibot calls wifiReconnect(),
+// which starts one connection attempt without disconnecting first
+void wifiBegin(const char* ssid, const char* password, LinkEventHandler handler);
+bool wifiConnected();
+void wifiReconnect();
+uint32_t localIP();
+uint8_t wifiChannel();              // the AP's channel, 0 if not associated
+
+// Leaves the AP, scans passively, then listens dwellMs on each channel in
+// promiscuous mode. Returns how many channels it filled in (the country's
+// channel set, at most maxChannels). Blocks for a few seconds; rejoin with
+// wifiReconnect() afterwards.
+int wifiSurvey(ChannelSurvey* out, int maxChannels, uint32_t dwellMs);
+
+// Two UDP sockets, bound to any address (broadcasts included):
+//  - the data socket, opened and closed as needed (Minibot: the command port)
+//  - the control socket, bound once and left open (Minibot: the discovery
+//    port), with a receive queue of its own that a flood on the data port
+//    can't fill
+// udpSend() goes out from the data socket, or the control socket while the
+// data socket is closed.
+bool udpBind(uint16_t port);
+void udpClose();
+int udpReceive(char* buffer, int size, uint32_t* fromIP);  // bytes, 0 if none waiting
+bool udpBindControl(uint16_t port);                         // rebinds if already open
+int udpReceiveControl(char* buffer, int size, uint32_t* fromIP);
+bool udpSend(uint32_t ip, uint16_t port, const void* data, int len);
+
+inline void formatIP(uint32_t ip, char* out, size_t len) {
+    const uint8_t* b = (const uint8_t*)&ip;
+    snprintf(out, len, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+}
+
+}  // namespace platform
+
+#endif
@@ -31,6 +31,7 @@
 #define MOTOR_REVERSE_LEFT  false   // Set true to reverse left motor
 #define MOTOR_REVERSE_RIGHT false   // Set true to reverse right motor
 #define MAX_SPEED 1.0          // Max speed multiplier (0.0 to 1.0)
+#define USE_PLAYOUT_BUFFER false    // Smooth out jittery WiFi (adds ~10-80ms fixed delay)
 
 // ============ END CONFIGURATION ============
 
@@ -53,6 +54,7 @@ float applyDeadzone(uint8_t value, uint8_t deadzone = DEADZONE) {
 
 void setup() {
     // All setup is handled in Minibot constructor
+    bot.enablePlayoutBuffer(USE_PLAYOUT_BUFFER);
     Serial.println("Robot Type: "
     #if defined(ROBOT_TYPE_TANK_DRIVE)
         "Tank Drive"
@@ -0,0 +1,113 @@
+// Minibot platform backend for the Arduino core
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <stdarg.h>
+
+#include "minibot_platform.h"
+
+namespace {
+WiFiUDP udp;         // data socket
+WiFiUDP controlUdp;  // control socket
+bool udpOpen = false;
+
+int receiveFrom(WiFiUDP& u, char* buffer, int size, uint32_t* fromIP) {
+    if(!u.parsePacket()) return 0;
+    int len = u.read(buffer, size);
+    *fromIP = (uint32_t)u.remoteIP();
+    return len > 0 ? len : 0;
+}
+LinkEventHandler linkHandler = nullptr;
+
+void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    if(!linkHandler) return;
+    switch(event) {
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        linkHandler(LINK_DISCONNECTED, info.wifi_sta_disconnected.reason);
+        break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+        linkHandler(LINK_LOST_IP, 0);
+        break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        linkHandler(LINK_GOT_IP, 0);
+        break;
+    default:
+        break;
+    }
+}
+}  // namespace
+
+namespace platform {
+
+const char* name() { return "arduino"; }
+
+void begin() {
+    Serial.begin(115200);
+    delay(100);
+}
+
+void log(const char* fmt, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    Serial.println(line);
+}
+
+uint32_t millis() { return ::millis(); }
+uint64_t micros() { return esp_timer_get_time(); }
+void delayMs(uint32_t ms) { delay(ms); }
+uint32_t freeHeap() { return ESP.getFreeHeap(); }
+uint32_t minFreeHeap() { return ESP.getMinFreeHeap(); }
+
+void wifiBegin(const char* ssid, const char* password, LinkEventHandler handler) {
+    linkHandler = handler;
+    WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+    WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.setAutoReconnect(false);
+    WiFi.begin(ssid, password);
+}
+
+bool wifiConnected() { return WiFi.status() == WL_CONNECTED; }
+// Not WiFi.reconnect(): that disconnects first, aborting any attempt still
+// associating or waiting for DHCP and firing a DISCONNECTED of its own
+void wifiReconnect() { esp_wifi_connect(); }
+uint32_t localIP() { return (uint32_t)WiFi.localIP(); }
+
+bool udpBind(uint16_t port) {
+    udpOpen = udp.begin(port);
+    return udpOpen;
+}
+
+void udpClose() {
+    udp.stop();
+    udpOpen = false;
+}
+
+int udpReceive(char* buffer, int size, uint32_t* fromIP) { return receiveFrom(udp, buffer, size, fromIP); }
+
+bool udpBindControl(uint16_t port) {
+    controlUdp.stop();
+    return controlUdp.begin(port);
+}
+
+int udpReceiveControl(char* buffer, int size, uint32_t* fromIP) {
+    return receiveFrom(controlUdp, buffer, size, fromIP);
+}
+
+bool udpSend(uint32_t ip, uint16_t port, const void* data, int len) {
+    WiFiUDP& u = udpOpen ? udp : controlUdp;
+    if(!u.beginPacket(IPAddress(ip), port)) return false;
+    u.write((const uint8_t*)data, len);
+    return u.endPacket();
+}
+
+}  // namespace platform
+
+#endif
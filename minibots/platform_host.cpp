@@ -0,0 +1,186 @@
+// Minibot platform backend for host builds (benchmarks); see platform_host.h
+#ifdef MINIBOT_HOST
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <deque>
+
+#include "platform_host.h"
+
+#define HOST_RECV_QUEUE 64  // packets per socket, as a generous lwIP recvmbox
+
+namespace {
+struct Packet {
+    uint32_t fromIP;
+    int len;
+    char data[256];
+};
+
+uint32_t nowMs = 0;
+const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+LinkEventHandler linkHandler = nullptr;
+bool linkUp = true;
+bool associated = true;  // wifiChannel() is the AP's, with or without an address
+platform::host::JoinResult joinResult = platform::host::JOIN_OK;
+uint32_t reconnectCount = 0;
+bool bound = false;
+bool controlBound = false;
+std::deque<Packet> inbox;         // data socket
+std::deque<Packet> controlInbox;  // control socket
+uint32_t droppedCount = 0;
+uint32_t sentCount = 0;
+char lastSentText[512];
+// Like lwIP's per-socket receive mailbox: full means the packet is lost
+void deliver(std::deque<Packet>& queue, uint32_t fromIP, const void* data, int len) {
+    if(queue.size() >= HOST_RECV_QUEUE) {
+        droppedCount++;
+        return;
+    }
+    Packet p;
+    p.fromIP = fromIP;
+    p.len = len < (int)sizeof(p.data) ? len : sizeof(p.data);
+    memcpy(p.data, data, p.len);
+    queue.push_back(p);
+}
+
+int take(std::deque<Packet>& queue, char* buffer, int size, uint32_t* fromIP) {
+    if(queue.empty()) return 0;
+    const Packet& p = queue.front();
+    int len = p.len < size ? p.len : size;
+    memcpy(buffer, p.data, len);
+    *fromIP = p.fromIP;
+    queue.pop_front();
+    return len;
+}
+}  // namespace
+
+namespace platform {
+
+const char* name() { return "host"; }
+void begin() {}
+
+void log(const char* fmt, ...) {
+    // Quiet unless asked: the benchmarks time the code around it
+    if(!getenv("MINIBOT_HOST_LOG")) return;
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+uint32_t millis() { return nowMs; }
+
+uint64_t micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delayMs(uint32_t ms) { nowMs += ms; }
+uint32_t freeHeap() { return 0; }
+uint32_t minFreeHeap() { return 0; }
+
+void wifiBegin(const char*, const char*, LinkEventHandler handler) { linkHandler = handler; }
+bool wifiConnected() { return linkUp; }
+void wifiReconnect() {
+    reconnectCount++;
+    if(linkUp) return;
+    switch(joinResult) {
+    case host::JOIN_OK:
+        linkUp = associated = true;
+        if(linkHandler) linkHandler(LINK_GOT_IP, 0);
+        break;
+    case host::JOIN_NO_AP:
+        if(linkHandler) linkHandler(LINK_DISCONNECTED, 201);  // WIFI_REASON_NO_AP_FOUND
+        break;
+    case host::JOIN_NO_DHCP:
+        associated = true;
+        break;
+    case host::JOIN_SILENT:
+        break;
+    }
+}
+uint32_t localIP() { return 0x0A01A8C0; }  // 192.168.1.10
+uint8_t wifiChannel() { return associated ? 6 : 0; }
+
+int wifiSurvey(ChannelSurvey* out, int maxChannels, uint32_t dwellMs) {
+    // A quiet band; only the time it takes is simulated
+    int count = maxChannels < 13 ? maxChannels : 13;
+    for(int i = 0; i < count; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].channel = i + 1;
+        nowMs += dwellMs;
+    }
+    linkUp = associated = false;
+    if(linkHandler) linkHandler(LINK_DISCONNECTED, 8);  // WIFI_REASON_ASSOC_LEAVE
+    return count;
+}
+
+bool udpBind(uint16_t) {
+    bound = true;
+    return true;
+}
+
+void udpClose() {
+    bound = false;
+}
+
+int udpReceive(char* buffer, int size, uint32_t* fromIP) {
+    if(!bound) return 0;
+    return take(inbox, buffer, size, fromIP);
+}
+
+bool udpBindControl(uint16_t) {
+    controlBound = true;
+    return true;
+}
+
+int udpReceiveControl(char* buffer, int size, uint32_t* fromIP) {
+    if(!controlBound) return 0;
+    return take(controlInbox, buffer, size, fromIP);
+}
+
+bool udpSend(uint32_t, uint16_t, const void* data, int len) {
+    if(!bound && !controlBound) return false;
+    int n = len < (int)sizeof(lastSentText) - 1 ? len : (int)sizeof(lastSentText) - 1;
+    memcpy(lastSentText, data, n);
+    lastSentText[n] = '\0';
+    sentCount++;
+    return true;
+}
+
+namespace host {
+
+void advanceMs(uint32_t ms) { nowMs += ms; }
+
+void queuePacket(uint32_t fromIP, const void* data, int len) {
+    // Wherever the robot listens: its command port once paired, otherwise
+    // the discovery port
+    deliver(bound ? inbox : controlInbox, fromIP, data, len);
+}
+
+void queueControlPacket(uint32_t fromIP, const void* data, int len) {
+    deliver(controlInbox, fromIP, data, len);
+}
+
+uint32_t packetsQueued() { return inbox.size() + controlInbox.size(); }
+uint32_t packetsDropped() { return droppedCount; }
+uint32_t packetsSent() { return sentCount; }
+const char* lastSent() { return lastSentText; }
+
+void setJoinResult(JoinResult result) { joinResult = result; }
+uint32_t reconnects() { return reconnectCount; }
+
+void setLink(bool up, uint16_t reason) {
+    linkUp = associated = up;
+    if(linkHandler) linkHandler(up ? LINK_GOT_IP : LINK_DISCONNECTED, reason);
+}
+
+}  // namespace host
+}  // namespace platform
+
+#endif
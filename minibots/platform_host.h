@@ -0,0 +1,35 @@
+#ifndef PLATFORM_HOST_H
+#define PLATFORM_HOST_H
+
+#include "minibot_platform.h"
+
+// Extra controls for the host backend (platform_host.cpp), which runs
+// Minibot on a PC for benchmarks: a simulated millis() clock, an
+// in-memory UDP sockets with bounded receive queues and a link that is up
+// unless told otherwise.
+namespace platform {
+namespace host {
+
+// What wifiReconnect() does while the link is down
+enum JoinResult {
+    JOIN_OK,       // associates and gets an address (GOT_IP)
+    JOIN_NO_AP,    // fails at once with reason 201 (NO_AP_FOUND)
+    JOIN_NO_DHCP,  // associates, then never gets an address: no event
+    JOIN_SILENT,   // never associates and never reports back
+};
+
+void advanceMs(uint32_t ms);
+void queuePacket(uint32_t fromIP, const void* data, int len);         // to where the robot listens
+void queueControlPacket(uint32_t fromIP, const void* data, int len);  // to the control socket
+uint32_t packetsQueued();
+uint32_t packetsDropped();                   // lost to a full receive queue
+uint32_t packetsSent();
+const char* lastSent();                      // newest packet sent, as text
+void setLink(bool up, uint16_t reason = 0);  // fires the link handler
+void setJoinResult(JoinResult result);       // JOIN_OK by default
+uint32_t reconnects();                       // wifiReconnect() calls so far
+
+}  // namespace host
+}  // namespace platform
+
+#endif
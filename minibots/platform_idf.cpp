@@ -0,0 +1,188 @@
+// Minibot platform backend for a plain ESP-IDF build: esp_wifi, esp_event
+// and lwIP sockets, with no Arduino layer in between
+#if defined(ESP_PLATFORM) && !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "nvs_flash.h"
+
+#include "minibot_platform.h"
+
+namespace {
+LinkEventHandler linkHandler = nullptr;
+esp_netif_t* staNetif = nullptr;
+volatile bool haveIP = false;
+int sock = -1;         // data socket
+int controlSock = -1;  // control socket
+
+// Non-blocking, broadcast-capable UDP socket on port; -1 on failure
+int openSocket(uint16_t port) {
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if(s < 0) return -1;
+
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(s, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(s, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+int receiveFrom(int s, char* buffer, int size, uint32_t* fromIP) {
+    if(s < 0) return 0;
+    sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(s, buffer, size, MSG_DONTWAIT, (sockaddr*)&from, &fromLen);
+    if(len <= 0) return 0;
+    *fromIP = from.sin_addr.s_addr;
+    return len;
+}
+
+void onWifiEvent(void*, esp_event_base_t, int32_t id, void* data) {
+    switch(id) {
+    case WIFI_EVENT_STA_START:
+        esp_wifi_connect();
+        break;
+    case WIFI_EVENT_STA_DISCONNECTED:
+        haveIP = false;
+        if(linkHandler) linkHandler(LINK_DISCONNECTED, ((wifi_event_sta_disconnected_t*)data)->reason);
+        break;
+    default:
+        break;
+    }
+}
+
+void onIpEvent(void*, esp_event_base_t, int32_t id, void*) {
+    switch(id) {
+    case IP_EVENT_STA_GOT_IP:
+        haveIP = true;
+        if(linkHandler) linkHandler(LINK_GOT_IP, 0);
+        break;
+    case IP_EVENT_STA_LOST_IP:
+        haveIP = false;
+        if(linkHandler) linkHandler(LINK_LOST_IP, 0);
+        break;
+    default:
+        break;
+    }
+}
+}  // namespace
+
+namespace platform {
+
+const char* name() { return "esp-idf"; }
+
+void begin() {
+    // The console UART is already up
+}
+
+void log(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+uint32_t millis() { return (uint32_t)(esp_timer_get_time() / 1000); }
+uint64_t micros() { return esp_timer_get_time(); }
+
+void delayMs(uint32_t ms) {
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ms && !ticks ? 1 : ticks);  // round up below one tick
+}
+
+uint32_t freeHeap() { return esp_get_free_heap_size(); }
+uint32_t minFreeHeap() { return esp_get_minimum_free_heap_size(); }
+
+void wifiBegin(const char* ssid, const char* password, LinkEventHandler handler) {
+    linkHandler = handler;
+
+    esp_err_t err = nvs_flash_init();  // the WiFi driver keeps calibration data there
+    if(err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
+    esp_netif_init();
+    esp_event_loop_create_default();
+    staNetif = esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t init = WIFI_INIT_CONFIG_DEFAULT();
+    esp_wifi_init(&init);
+    esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, onWifiEvent, nullptr, nullptr);
+    esp_event_handler_instance_register(IP_EVENT, ESP_EVENT_ANY_ID, onIpEvent, nullptr, nullptr);
+
+    wifi_config_t config = {};
+    strncpy((char*)config.sta.ssid, ssid, sizeof(config.sta.ssid));
+    strncpy((char*)config.sta.password, password, sizeof(config.sta.password));
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_wifi_set_mode(WIFI_MODE_STA);
+    esp_wifi_set_config(WIFI_IF_STA, &config);
+    esp_wifi_start();  // connects from WIFI_EVENT_STA_START
+}
+
+bool wifiConnected() { return haveIP; }
+void wifiReconnect() { esp_wifi_connect(); }
+
+uint32_t localIP() {
+    esp_netif_ip_info_t info;
+    if(!staNetif || esp_netif_get_ip_info(staNetif, &info) != ESP_OK) return 0;
+    return info.ip.addr;
+}
+
+bool udpBind(uint16_t port) {
+    udpClose();
+    sock = openSocket(port);
+    return sock >= 0;
+}
+
+void udpClose() {
+    if(sock >= 0) close(sock);
+    sock = -1;
+}
+
+int udpReceive(char* buffer, int size, uint32_t* fromIP) {
+    return receiveFrom(sock, buffer, size, fromIP);
+}
+
+bool udpBindControl(uint16_t port) {
+    if(controlSock >= 0) close(controlSock);
+    controlSock = openSocket(port);
+    return controlSock >= 0;
+}
+
+int udpReceiveControl(char* buffer, int size, uint32_t* fromIP) {
+    return receiveFrom(controlSock, buffer, size, fromIP);
+}
+
+bool udpSend(uint32_t ip, uint16_t port, const void* data, int len) {
+    int s = sock >= 0 ? sock : controlSock;
+    if(s < 0) return false;
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    to.sin_addr.s_addr = ip;
+    return sendto(s, data, len, 0, (sockaddr*)&to, sizeof(to)) == len;
+}
+
+}  // namespace platform
+
+#endif
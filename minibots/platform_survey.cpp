@@ -0,0 +1,127 @@
+// Channel survey for both ESP32 backends (the Arduino core sits on the same
+// esp_wifi driver). See platform::wifiSurvey() in minibot_platform.h.
+#if defined(ESP_PLATFORM) && !defined(MINIBOT_HOST)
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_wifi.h"
+
+#include "minibot_platform.h"
+
+#define SURVEY_SCAN_MS 120  // passive dwell per channel: one beacon interval plus margin
+
+namespace {
+// Written from the WiFi task's promiscuous callback
+volatile uint32_t heardFrames = 0;
+volatile uint32_t heardAirUs = 0;
+
+// On-air time of one received frame: PLCP preamble/header plus the PSDU at
+// its rate. Frames we can't decode (other PHYs, collisions, non-WiFi) are
+// invisible here, so this is a lower bound on how busy the channel is.
+uint32_t airtimeUs(const wifi_pkt_rx_ctrl_t& rx) {
+    uint32_t bits = rx.sig_len * 8;
+    if(rx.sig_mode == 0) {
+        switch(rx.rate) {  // wifi_phy_rate_t
+        case WIFI_PHY_RATE_1M_L:  return 192 + bits;
+        case WIFI_PHY_RATE_2M_L:  return 192 + bits / 2;
+        case WIFI_PHY_RATE_5M_L:  return 192 + bits * 2 / 11;
+        case WIFI_PHY_RATE_11M_L: return 192 + bits / 11;
+        case WIFI_PHY_RATE_2M_S:  return 96 + bits / 2;
+        case WIFI_PHY_RATE_5M_S:  return 96 + bits * 2 / 11;
+        case WIFI_PHY_RATE_11M_S: return 96 + bits / 11;
+        case WIFI_PHY_RATE_6M:    return 20 + bits / 6;
+        case WIFI_PHY_RATE_9M:    return 20 + bits / 9;
+        case WIFI_PHY_RATE_12M:   return 20 + bits / 12;
+        case WIFI_PHY_RATE_18M:   return 20 + bits / 18;
+        case WIFI_PHY_RATE_24M:   return 20 + bits / 24;
+        case WIFI_PHY_RATE_36M:   return 20 + bits / 36;
+        case WIFI_PHY_RATE_48M:   return 20 + bits / 48;
+        default:                  return 20 + bits / 54;
+        }
+    }
+    // 802.11n, one stream, 20 MHz, long GI: MCS0-7 in 100 kbps
+    static const uint16_t htRate[8] = {65, 130, 195, 260, 390, 520, 585, 650};
+    return 36 + bits * 10 / htRate[rx.mcs & 7];
+}
+
+void onFrame(void* buf, wifi_promiscuous_pkt_type_t) {
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    heardFrames = heardFrames + 1;
+    heardAirUs = heardAirUs + airtimeUs(pkt->rx_ctrl);
+}
+}  // namespace
+
+namespace platform {
+
+uint8_t wifiChannel() {
+    wifi_ap_record_t ap;
+    if(esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return 0;
+    return ap.primary;
+}
+
+int wifiSurvey(ChannelSurvey* out, int maxChannels, uint32_t dwellMs) {
+    wifi_country_t country;
+    int first = 1, count = 13;
+    if(esp_wifi_get_country(&country) == ESP_OK && country.nchan) {
+        first = country.schan;
+        count = country.nchan;
+    }
+    if(count > maxChannels) count = maxChannels;
+    for(int i = 0; i < count; i++) {
+        memset(&out[i], 0, sizeof(out[i]));
+        out[i].channel = first + i;
+    }
+
+    // Scanning and channel changes need the station idle
+    esp_wifi_disconnect();
+
+    // 1. Who else is here: passive scan, beacons only, nothing transmitted
+    wifi_scan_config_t scan = {};
+    scan.show_hidden = true;
+    scan.scan_type = WIFI_SCAN_TYPE_PASSIVE;
+    scan.scan_time.passive = SURVEY_SCAN_MS;
+    if(esp_wifi_scan_start(&scan, true) == ESP_OK) {
+        uint16_t found = 0;
+        esp_wifi_scan_get_ap_num(&found);
+        if(found > 32) found = 32;
+        // Fetching the records frees the driver's list, so fetch at least one
+        wifi_ap_record_t one;
+        wifi_ap_record_t* aps = found > 1 ? (wifi_ap_record_t*)malloc(sizeof(wifi_ap_record_t) * found) : nullptr;
+        if(!aps && found > 1) found = 1;
+        if(esp_wifi_scan_get_ap_records(&found, aps ? aps : &one) == ESP_OK) {
+            const wifi_ap_record_t* ap = aps ? aps : &one;
+            for(uint16_t i = 0; i < found; i++) {
+                int slot = ap[i].primary - first;
+                if(slot < 0 || slot >= count) continue;
+                ChannelSurvey& c = out[slot];
+                if(c.networks < 255) c.networks++;
+                if(c.strongestRssi == 0 || ap[i].rssi > c.strongestRssi) c.strongestRssi = ap[i].rssi;
+            }
+        }
+        free(aps);
+    }
+
+    // 2. How busy: sit on each channel and add up the airtime of what we hear
+    wifi_promiscuous_filter_t filter = {};
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_ALL;
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(onFrame);
+    esp_wifi_set_promiscuous(true);
+    for(int i = 0; i < count; i++) {
+        esp_wifi_set_channel(out[i].channel, WIFI_SECOND_CHAN_NONE);
+        heardFrames = 0;
+        heardAirUs = 0;
+        delayMs(dwellMs);
+        uint32_t busy = heardAirUs / (dwellMs ? dwellMs : 1);  // us per ms = permille
+        out[i].busyPermille = busy > 1000 ? 1000 : busy;
+        out[i].frames = heardFrames > 0xFFFF ? 0xFFFF : heardFrames;
+    }
+    esp_wifi_set_promiscuous(false);
+    esp_wifi_set_promiscuous_rx_cb(nullptr);
+    return count;
+}
+
+}  // namespace platform
+
+#endif
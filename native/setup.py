@@ -0,0 +1,27 @@
+#!/usr/bin/env python3
+"""
+Build the driver station's native transmit core (Linux only)
+
+    cd native
+    python setup.py build_ext --inplace
+
+driver_station.py picks up native/station_tx*.so automatically and falls
+back to sending from Python when it isn't built.
+"""
+
+from setuptools import Extension, setup
+
+setup(
+    name="station_tx",
+    version="1.0",
+    description="Native transmit core for the Minibot driver station",
+    ext_modules=[
+        Extension(
+            "station_tx",
+            sources=["station_tx.cpp"],
+            language="c++",
+            extra_compile_args=["-std=c++17", "-O2", "-Wall"],
+            extra_link_args=["-pthread"],
+        )
+    ],
+)
@@ -0,0 +1,941 @@
+/*
+ * station_tx - native transmit core for driver_station.py
+ *
+ * Holds one 30-byte control frame per robot, re-encodes it from the latest
+ * controller state every tick and sends the fleet's frames from its own
+ * thread. Python only pushes state and policy (who is enabled); the
+ * transmit thread never touches the GIL.
+ *
+ * Pacing modes:
+ *   batch  - every frame in one sendmmsg() as soon as the tick wakes up
+ *   soft   - each robot gets its own launch instant, spread evenly across
+ *            the tick; the thread sleeps to it (clock_nanosleep) and sends
+ *   txtime - the same launch instants handed to the kernel with SO_TXTIME,
+ *            queued `lead` ahead of time, so the ETF qdisc (CLOCK_TAI) or
+ *            fq (CLOCK_MONOTONIC) releases them and thread wakeup jitter
+ *            up to `lead` never reaches the wire
+ *
+ * Staleness deadline: a robot whose state Python hasn't refreshed (set_state
+ * or set_enabled) within stale_ms gets no more frames until it is refreshed.
+ * A hung UI or interpreter then stops traffic the way it did when Python
+ * sent the frames itself, and the robot's command timeout stops it.
+ *
+ * Real-time mode (set_realtime) pins the transmit thread to one CPU, runs
+ * it SCHED_FIFO and pre-faults its buffers and stack; lock_memory() keeps
+ * the whole process resident and wakeup_latency() is the self-test that
+ * says how late such a thread wakes on this machine.
+ *
+ * Linux only (sendmmsg, clock_nanosleep, SO_TXTIME). Build: see native/setup.py.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef SO_TXTIME
+#define SO_TXTIME 61
+#define SCM_TXTIME SO_TXTIME
+#endif
+
+namespace {
+
+// Control frame layout (see ARCHITECTURE.md)
+constexpr size_t FRAME_LEN = 30;
+constexpr size_t NAME_LEN = 16;
+constexpr size_t MAX_ROBOTS = 64;
+constexpr int64_t NS_PER_SEC = 1000000000LL;
+constexpr double DEFAULT_STALE_MS = 250.0;  // well inside the robot's 5 s command timeout
+
+enum class Pacing { Batch, Soft, TxTime };
+
+const char* pacingName(Pacing pacing) {
+    switch (pacing) {
+        case Pacing::Soft: return "soft";
+        case Pacing::TxTime: return "txtime";
+        default: return "batch";
+    }
+}
+
+inline int64_t toNs(const timespec& ts) {
+    return (int64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+inline timespec fromNs(int64_t ns) {
+    timespec ts;
+    ts.tv_sec = ns / NS_PER_SEC;
+    ts.tv_nsec = ns % NS_PER_SEC;
+    return ts;
+}
+
+inline int64_t clockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return toNs(ts);
+}
+
+inline int64_t monotonicNs() {
+    return clockNs(CLOCK_MONOTONIC);
+}
+
+inline void sleepUntil(int64_t ns) {
+    timespec wake = fromNs(ns);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {}
+}
+
+// Real-time settings for a thread: cpu < 0 leaves affinity alone,
+// priority 0 keeps the normal scheduler
+struct RtConfig {
+    int cpu = -1;
+    int priority = 0;
+};
+
+// Apply to the calling thread; returns 0 or the first errno
+int applyRealtime(const RtConfig& rt) {
+    int err = 0;
+    if (rt.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(rt.cpu, &set);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    if (rt.priority > 0) {
+        sched_param param;
+        param.sched_priority = rt.priority;
+        int schedErr = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (!err) err = schedErr;
+    }
+    return err;
+}
+
+// Touch a chunk of stack so the first deep call in the loop doesn't page fault
+void prefaultStack() {
+    constexpr size_t STACK_PREFAULT = 64 * 1024;
+    volatile uint8_t buffer[STACK_PREFAULT];
+    for (size_t i = 0; i < STACK_PREFAULT; i += 4096) buffer[i] = 0;
+    (void)buffer;
+}
+
+struct RobotSlot {
+    std::string id;
+    uint64_t key = 0;            // stays valid while a tick is in flight without the lock
+    sockaddr_in addr;
+    uint8_t frame[FRAME_LEN];
+    uint8_t axes[4] = {127, 127, 127, 127};
+    uint8_t buttons = 0;
+    bool enabled = false;
+    bool stale = false;          // past the deadline; cleared by the next refresh
+    int64_t refreshedNs = 0;     // last set_state/set_enabled (CLOCK_MONOTONIC)
+    uint16_t seq = 0;
+    uint64_t framesSent = 0;
+    uint64_t sendErrors = 0;
+};
+
+struct TxStats {
+    uint64_t ticks = 0;
+    uint64_t batches = 0;        // sendmmsg calls
+    uint64_t framesSent = 0;
+    uint64_t sendErrors = 0;
+    uint64_t overruns = 0;       // ticks that started more than a period late
+    uint64_t stalls = 0;         // times a robot went past the staleness deadline
+    int64_t wakeLateMaxNs = 0;   // worst wakeup after the scheduled tick
+    int64_t wakeLateSumNs = 0;
+    int64_t launchLateMaxNs = 0; // send returned after the frame's launch instant (batch/soft)
+    int64_t launchLateSumNs = 0;
+    uint64_t launches = 0;
+    int64_t leadMinNs = 0;       // txtime: least time a frame was queued ahead of its launch
+    uint64_t txtimeMissed = 0;   // reported back by the qdisc through the error queue
+    uint64_t txtimeInvalid = 0;
+    int lastErrno = 0;
+    int rtErrno = 0;             // applying the real-time settings failed (EPERM, EINVAL)
+};
+
+// One frame on its way out, copied from its RobotSlot so sending can
+// happen without holding the lock
+struct Outgoing {
+    uint64_t key;
+    sockaddr_in addr;
+    uint8_t frame[FRAME_LEN];
+    int64_t launchNs;            // CLOCK_MONOTONIC
+    alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(uint64_t))];
+    bool sent;
+};
+
+class TxCore {
+public:
+    TxCore(int fd, double rateHz, Pacing pacing, clockid_t txClock, int64_t leadNs, int64_t staleNs)
+        : fd_(fd), periodNs_((int64_t)(NS_PER_SEC / rateHz)), pacing_(pacing),
+          txClock_(txClock), leadNs_(leadNs), staleNs_(staleNs) {
+        robots_.reserve(MAX_ROBOTS);
+        out_.resize(MAX_ROBOTS);
+        msgs_.resize(MAX_ROBOTS);
+        iovs_.resize(MAX_ROBOTS);
+    }
+
+    // Takes effect when the thread next starts
+    void setRealtime(const RtConfig& rt) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        rt_ = rt;
+    }
+
+    RtConfig realtime() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return rt_;
+    }
+
+    // Turn on SO_TXTIME for this socket; returns 0 or an errno
+    int enableTxTime() {
+        sock_txtime config;
+        config.clockid = txClock_;
+        config.flags = SOF_TXTIME_REPORT_ERRORS;
+        return setsockopt(fd_, SOL_SOCKET, SO_TXTIME, &config, sizeof(config)) < 0 ? errno : 0;
+    }
+
+    ~TxCore() {
+        stop();
+        close(fd_);
+    }
+
+    bool setRobot(const std::string& id, const sockaddr_in& addr) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        RobotSlot* slot = find(id);
+        if (!slot) {
+            if (robots_.size() >= MAX_ROBOTS) return false;
+            robots_.emplace_back();
+            slot = &robots_.back();
+            slot->id = id;
+            slot->key = ++nextKey_;
+            memset(slot->frame, 0, FRAME_LEN);
+            memcpy(slot->frame, id.data(), id.size() < NAME_LEN - 1 ? id.size() : NAME_LEN - 1);
+        }
+        slot->addr = addr;
+        return true;
+    }
+
+    bool removeRobot(const std::string& id) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (size_t i = 0; i < robots_.size(); i++) {
+            if (robots_[i].id == id) {
+                robots_.erase(robots_.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool setState(const std::string& id, const uint8_t axes[4], uint8_t buttons) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        RobotSlot* slot = find(id);
+        if (!slot) return false;
+        memcpy(slot->axes, axes, 4);
+        slot->buttons = buttons;
+        refresh(*slot);
+        return true;
+    }
+
+    bool setEnabled(const std::string& id, bool enabled) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        RobotSlot* slot = find(id);
+        if (!slot) return false;
+        slot->enabled = enabled;
+        refresh(*slot);
+        return true;
+    }
+
+    bool robotStats(const std::string& id, uint64_t& framesSent, uint64_t& errors, uint16_t& seq, bool& stale) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        RobotSlot* slot = find(id);
+        if (!slot) return false;
+        framesSent = slot->framesSent;
+        errors = slot->sendErrors;
+        seq = slot->seq;
+        stale = slot->stale;
+        return true;
+    }
+
+    TxStats stats() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return stats_;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stats_ = TxStats();
+    }
+
+    void start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread(&TxCore::run, this);
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) return;
+        if (thread_.joinable()) thread_.join();
+    }
+
+    bool running() const { return running_; }
+    double rateHz() const { return (double)NS_PER_SEC / periodNs_; }
+    Pacing pacing() const { return pacing_; }
+    double staleMs() const { return staleNs_ / 1e6; }
+
+private:
+    void refresh(RobotSlot& slot) {
+        slot.refreshedNs = monotonicNs();
+        slot.stale = false;
+    }
+
+    RobotSlot* find(const std::string& id) {
+        for (auto& slot : robots_) {
+            if (slot.id == id) return &slot;
+        }
+        return nullptr;
+    }
+
+    static void encode(RobotSlot& slot, uint32_t stampMs) {
+        // Bytes 0-15 (name) are written once in setRobot()
+        uint8_t* f = slot.frame;
+        f[16] = slot.axes[0];
+        f[17] = slot.axes[1];
+        f[18] = slot.axes[2];
+        f[19] = slot.axes[3];
+        f[20] = 127;  // extra axes (unused)
+        f[21] = 127;
+        f[22] = slot.buttons;
+        f[23] = 0;
+        slot.seq++;
+        f[24] = slot.seq & 0xFF;
+        f[25] = slot.seq >> 8;
+        f[26] = stampMs & 0xFF;
+        f[27] = (stampMs >> 8) & 0xFF;
+        f[28] = (stampMs >> 16) & 0xFF;
+        f[29] = (stampMs >> 24) & 0xFF;
+    }
+
+    void run() {
+        int rtErr = applyRealtime(realtime());
+        prefault();
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stats_.rtErrno = rtErr;
+        }
+
+        int64_t next = monotonicNs();
+
+        while (running_) {
+            next += periodNs_;
+            sleepUntil(next);
+            if (!running_) break;
+
+            int64_t now = monotonicNs();
+            unsigned n = prepare(next, now);
+            if (n == 0) continue;
+
+            switch (pacing_) {
+                case Pacing::Batch: sendBatch(n); break;
+                case Pacing::Soft: sendPaced(n); break;
+                case Pacing::TxTime: sendTxTime(n); break;
+            }
+            finish(n);
+            if (pacing_ == Pacing::TxTime) drainErrorQueue();
+        }
+    }
+
+    // Write every per-tick buffer once so the loop itself never faults a page in
+    void prefault() {
+        prefaultStack();
+        for (auto& out : out_) memset(&out, 0, sizeof(out));
+        memset(msgs_.data(), 0, msgs_.size() * sizeof(mmsghdr));
+        memset(iovs_.data(), 0, iovs_.size() * sizeof(iovec));
+    }
+
+    // Under the lock: tick stats, encode every enabled robot's frame and
+    // copy it out with its launch instant. Returns the number of frames.
+    unsigned prepare(int64_t& next, int64_t now) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        int64_t late = now - next;
+        stats_.ticks++;
+        stats_.wakeLateSumNs += late;
+        if (late > stats_.wakeLateMaxNs) stats_.wakeLateMaxNs = late;
+        if (late > periodNs_) {
+            // Fell behind (suspend, heavy load): resync instead of bursting
+            stats_.overruns++;
+            next = now;
+        }
+
+        int64_t base = pacing_ == Pacing::TxTime ? next + leadNs_ : next;
+        unsigned enabled = 0;
+        for (auto& slot : robots_) {
+            if (!slot.enabled || slot.stale) continue;
+            if (now - slot.refreshedNs > staleNs_) {
+                // Python stopped refreshing this robot: go quiet rather than
+                // repeat its last stick values forever
+                slot.stale = true;
+                stats_.stalls++;
+                continue;
+            }
+            enabled++;
+        }
+
+        unsigned n = 0;
+        for (auto& slot : robots_) {
+            if (!slot.enabled || slot.stale) continue;
+            Outgoing& out = out_[n];
+            // Batch sends everything at the tick; paced modes give each
+            // robot its own slot so frames never leave back to back
+            out.launchNs = pacing_ == Pacing::Batch ? next : base + periodNs_ * n / enabled;
+            // Stamp with when the frame leaves, on the same clock and units
+            // as Python's time.monotonic() * 1000
+            encode(slot, (uint32_t)((out.launchNs > now ? out.launchNs : now) / 1000000));
+            out.key = slot.key;
+            out.addr = slot.addr;
+            memcpy(out.frame, slot.frame, FRAME_LEN);
+            out.sent = false;
+            n++;
+        }
+        return n;
+    }
+
+    void fillMessage(unsigned i) {
+        Outgoing& out = out_[i];
+        iovs_[i].iov_base = out.frame;
+        iovs_[i].iov_len = FRAME_LEN;
+        memset(&msgs_[i], 0, sizeof(mmsghdr));
+        msgs_[i].msg_hdr.msg_name = &out.addr;
+        msgs_[i].msg_hdr.msg_namelen = sizeof(out.addr);
+        msgs_[i].msg_hdr.msg_iov = &iovs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // sendmmsg() over msgs_[first, first + count). A failure reports the
+    // first unsent message's error; skip that one and carry on.
+    void sendRange(unsigned first, unsigned count) {
+        unsigned done = 0;
+        while (done < count) {
+            int sent = sendmmsg(fd_, &msgs_[first + done], count - done, 0);
+            batches_++;
+            if (sent < 0) {
+                lastErrno_ = errno;
+                done++;
+                continue;
+            }
+            for (int k = 0; k < sent; k++) out_[first + done + k].sent = true;
+            done += sent;
+        }
+    }
+
+    void recordLaunch(int64_t launchNs) {
+        int64_t late = monotonicNs() - launchNs;
+        launchLateSumNs_ += late;
+        launchLateMaxNs_ = late > launchLateMaxNs_ ? late : launchLateMaxNs_;
+        launches_++;
+    }
+
+    void sendBatch(unsigned n) {
+        for (unsigned i = 0; i < n; i++) fillMessage(i);
+        sendRange(0, n);
+        for (unsigned i = 0; i < n; i++) recordLaunch(out_[i].launchNs);
+    }
+
+    void sendPaced(unsigned n) {
+        for (unsigned i = 0; i < n; i++) {
+            fillMessage(i);
+            sleepUntil(out_[i].launchNs);
+            sendRange(i, 1);
+            recordLaunch(out_[i].launchNs);
+        }
+    }
+
+    void sendTxTime(unsigned n) {
+        // Launch instants are kept on CLOCK_MONOTONIC; translate them to the
+        // socket's SO_TXTIME clock once per tick
+        int64_t now = monotonicNs();
+        int64_t offset = txClock_ == CLOCK_MONOTONIC ? 0 : clockNs(txClock_) - now;
+        for (unsigned i = 0; i < n; i++) {
+            Outgoing& out = out_[i];
+            fillMessage(i);
+            msgs_[i].msg_hdr.msg_control = out.control;
+            msgs_[i].msg_hdr.msg_controllen = sizeof(out.control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs_[i].msg_hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+            uint64_t txtime = (uint64_t)(out.launchNs + offset);
+            memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+
+            int64_t lead = out.launchNs - now;
+            if (launches_ == 0 || lead < leadMinNs_) leadMinNs_ = lead;
+            launches_++;
+        }
+        sendRange(0, n);
+    }
+
+    // Frames the qdisc dropped come back on the socket's error queue
+    void drainErrorQueue() {
+        uint8_t data[64];
+        alignas(cmsghdr) uint8_t control[256];
+        for (;;) {
+            iovec iov = {data, sizeof(data)};
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (recvmsg(fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level != SOL_IP || cmsg->cmsg_type != IP_RECVERR) continue;
+                sock_extended_err err;
+                memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+                if (err.ee_origin != SO_EE_ORIGIN_TXTIME) continue;
+                if (err.ee_code == SO_EE_CODE_TXTIME_MISSED) txtimeMissed_++;
+                else txtimeInvalid_++;
+            }
+        }
+    }
+
+    // Under the lock again: fold this tick's results into the counters
+    void finish(unsigned n) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stats_.batches += batches_;
+        if (lastErrno_) stats_.lastErrno = lastErrno_;
+        if (launches_) {
+            stats_.launches += launches_;
+            stats_.launchLateSumNs += launchLateSumNs_;
+            if (launchLateMaxNs_ > stats_.launchLateMaxNs) stats_.launchLateMaxNs = launchLateMaxNs_;
+            if (pacing_ == Pacing::TxTime && (stats_.launches == launches_ || leadMinNs_ < stats_.leadMinNs)) {
+                stats_.leadMinNs = leadMinNs_;
+            }
+        }
+        stats_.txtimeMissed += txtimeMissed_;
+        stats_.txtimeInvalid += txtimeInvalid_;
+        batches_ = launches_ = txtimeMissed_ = txtimeInvalid_ = 0;
+        launchLateSumNs_ = launchLateMaxNs_ = leadMinNs_ = 0;
+        lastErrno_ = 0;
+
+        for (unsigned i = 0; i < n; i++) {
+            RobotSlot* slot = findKey(out_[i].key);  // may have been removed meanwhile
+            if (out_[i].sent) {
+                stats_.framesSent++;
+                if (slot) slot->framesSent++;
+            } else {
+                stats_.sendErrors++;
+                if (slot) slot->sendErrors++;
+            }
+        }
+    }
+
+    RobotSlot* findKey(uint64_t key) {
+        for (auto& slot : robots_) {
+            if (slot.key == key) return &slot;
+        }
+        return nullptr;
+    }
+
+    int fd_;
+    int64_t periodNs_;
+    Pacing pacing_;
+    clockid_t txClock_;
+    int64_t leadNs_;
+    int64_t staleNs_;
+    std::mutex mutex_;
+    std::vector<RobotSlot> robots_;
+    uint64_t nextKey_ = 0;
+    TxStats stats_;
+    RtConfig rt_;
+
+    // Transmit thread only
+    std::vector<Outgoing> out_;
+    std::vector<mmsghdr> msgs_;
+    std::vector<iovec> iovs_;
+    uint64_t batches_ = 0;
+    uint64_t launches_ = 0;
+    int64_t launchLateSumNs_ = 0;
+    int64_t launchLateMaxNs_ = 0;
+    int64_t leadMinNs_ = 0;
+    uint64_t txtimeMissed_ = 0;
+    uint64_t txtimeInvalid_ = 0;
+    int lastErrno_ = 0;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+// Self-test: a cyclictest-style loop with the same settings the transmit
+// thread would get. Latencies are bucketed at 1us up to 100ms.
+struct LatencyResult {
+    uint64_t samples = 0;
+    int64_t minNs = 0;
+    int64_t maxNs = 0;
+    int64_t sumNs = 0;
+    int64_t p99Ns = 0;
+    int64_t p999Ns = 0;
+    int rtErrno = 0;
+};
+
+LatencyResult measureWakeupLatency(double seconds, int64_t intervalNs, const RtConfig& rt) {
+    constexpr size_t BUCKETS = 100000;
+    std::vector<uint32_t> histogram(BUCKETS + 1, 0);
+    LatencyResult result;
+
+    std::thread worker([&] {
+        result.rtErrno = applyRealtime(rt);
+        prefaultStack();
+        int64_t start = monotonicNs();
+        int64_t end = start + (int64_t)(seconds * NS_PER_SEC);
+        int64_t next = start;
+        while (next < end) {
+            next += intervalNs;
+            sleepUntil(next);
+            int64_t latency = monotonicNs() - next;
+            if (result.samples == 0 || latency < result.minNs) result.minNs = latency;
+            if (latency > result.maxNs) result.maxNs = latency;
+            result.sumNs += latency;
+            result.samples++;
+            histogram[std::min<int64_t>(std::max<int64_t>(latency / 1000, 0), BUCKETS)]++;
+        }
+    });
+    worker.join();
+
+    uint64_t seen = 0;
+    for (size_t us = 0; us <= BUCKETS; us++) {
+        seen += histogram[us];
+        if (!result.p99Ns && seen * 100 >= result.samples * 99) result.p99Ns = us * 1000;
+        if (!result.p999Ns && seen * 1000 >= result.samples * 999) result.p999Ns = us * 1000;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Python binding
+
+struct TransmitterObject {
+    PyObject_HEAD
+    TxCore* core;
+};
+
+bool parseAddress(const char* ip, int port, sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    return port > 0 && port < 65536 && inet_pton(AF_INET, ip, &addr.sin_addr) == 1;
+}
+
+uint8_t clampByte(int value) {
+    return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+PyObject* unknownRobot(const char* id) {
+    PyErr_Format(PyExc_KeyError, "unknown robot '%s'", id);
+    return nullptr;
+}
+
+int Transmitter_init(TransmitterObject* self, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {"fd", "rate_hz", "pacing", "txtime_clock", "lead_us", "stale_ms", nullptr};
+    int fd;
+    double rateHz = 60.0;
+    const char* pacingArg = "batch";
+    const char* clockArg = "tai";
+    double leadUs = 1000.0;
+    double staleMs = DEFAULT_STALE_MS;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|dssdd", (char**)kwlist,
+                                     &fd, &rateHz, &pacingArg, &clockArg, &leadUs, &staleMs)) return -1;
+    if (rateHz <= 0 || rateHz > 10000) {
+        PyErr_SetString(PyExc_ValueError, "rate_hz must be in (0, 10000]");
+        return -1;
+    }
+    if (staleMs * 1e6 < NS_PER_SEC / rateHz) {
+        PyErr_SetString(PyExc_ValueError, "stale_ms must be at least one period");
+        return -1;
+    }
+
+    Pacing pacing;
+    if (strcmp(pacingArg, "batch") == 0) pacing = Pacing::Batch;
+    else if (strcmp(pacingArg, "soft") == 0) pacing = Pacing::Soft;
+    else if (strcmp(pacingArg, "txtime") == 0) pacing = Pacing::TxTime;
+    else {
+        PyErr_Format(PyExc_ValueError, "pacing must be 'batch', 'soft' or 'txtime', not '%s'", pacingArg);
+        return -1;
+    }
+    // ETF is normally configured on CLOCK_TAI; fq only accepts CLOCK_MONOTONIC
+    clockid_t txClock;
+    if (strcmp(clockArg, "tai") == 0) txClock = CLOCK_TAI;
+    else if (strcmp(clockArg, "monotonic") == 0) txClock = CLOCK_MONOTONIC;
+    else {
+        PyErr_Format(PyExc_ValueError, "txtime_clock must be 'tai' or 'monotonic', not '%s'", clockArg);
+        return -1;
+    }
+    if (leadUs < 0 || leadUs * 1000 >= NS_PER_SEC / rateHz) {
+        PyErr_SetString(PyExc_ValueError, "lead_us must be non-negative and shorter than one period");
+        return -1;
+    }
+
+    // Own a duplicate so Python closing its socket can't pull the fd from under us
+    int own = dup(fd);
+    if (own < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+    TxCore* core = new TxCore(own, rateHz, pacing, txClock, (int64_t)(leadUs * 1000), (int64_t)(staleMs * 1e6));
+    if (pacing == Pacing::TxTime) {
+        int err = core->enableTxTime();
+        if (err) {
+            delete core;
+            errno = err;
+            PyErr_SetFromErrno(PyExc_OSError);  // EPERM without CAP_NET_ADMIN for CLOCK_TAI
+            return -1;
+        }
+    }
+    delete self->core;
+    self->core = core;
+    return 0;
+}
+
+void Transmitter_dealloc(TransmitterObject* self) {
+    if (self->core) {
+        Py_BEGIN_ALLOW_THREADS
+        delete self->core;
+        Py_END_ALLOW_THREADS
+    }
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+#define REQUIRE_CORE(self) \
+    if (!(self)->core) { PyErr_SetString(PyExc_RuntimeError, "Transmitter not initialized"); return nullptr; }
+
+PyObject* Transmitter_set_robot(TransmitterObject* self, PyObject* args) {
+    REQUIRE_CORE(self);
+    const char* id;
+    const char* ip;
+    int port;
+    if (!PyArg_ParseTuple(args, "ssi", &id, &ip, &port)) return nullptr;
+    sockaddr_in addr;
+    if (!parseAddress(ip, port, addr)) {
+        PyErr_Format(PyExc_ValueError, "bad IPv4 address %s:%d", ip, port);
+        return nullptr;
+    }
+    if (!self->core->setRobot(id, addr)) {
+        PyErr_SetString(PyExc_OverflowError, "too many robots");
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_remove_robot(TransmitterObject* self, PyObject* args) {
+    REQUIRE_CORE(self);
+    const char* id;
+    if (!PyArg_ParseTuple(args, "s", &id)) return nullptr;
+    return PyBool_FromLong(self->core->removeRobot(id));
+}
+
+PyObject* Transmitter_set_state(TransmitterObject* self, PyObject* args) {
+    REQUIRE_CORE(self);
+    const char* id;
+    int lx, ly, rx, ry, buttons;
+    if (!PyArg_ParseTuple(args, "siiiii", &id, &lx, &ly, &rx, &ry, &buttons)) return nullptr;
+    uint8_t axes[4] = {clampByte(lx), clampByte(ly), clampByte(rx), clampByte(ry)};
+    if (!self->core->setState(id, axes, clampByte(buttons))) return unknownRobot(id);
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_set_enabled(TransmitterObject* self, PyObject* args) {
+    REQUIRE_CORE(self);
+    const char* id;
+    int enabled;
+    if (!PyArg_ParseTuple(args, "sp", &id, &enabled)) return nullptr;
+    if (!self->core->setEnabled(id, enabled)) return unknownRobot(id);
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_start(TransmitterObject* self, PyObject*) {
+    REQUIRE_CORE(self);
+    self->core->start();
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_stop(TransmitterObject* self, PyObject*) {
+    REQUIRE_CORE(self);
+    Py_BEGIN_ALLOW_THREADS
+    self->core->stop();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_set_realtime(TransmitterObject* self, PyObject* args, PyObject* kwds) {
+    REQUIRE_CORE(self);
+    static const char* kwlist[] = {"cpu", "priority", nullptr};
+    RtConfig rt;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ii", (char**)kwlist, &rt.cpu, &rt.priority)) return nullptr;
+    if (rt.priority < 0 || rt.priority > sched_get_priority_max(SCHED_FIFO)) {
+        PyErr_Format(PyExc_ValueError, "priority must be 0-%d", sched_get_priority_max(SCHED_FIFO));
+        return nullptr;
+    }
+    self->core->setRealtime(rt);
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_stats(TransmitterObject* self, PyObject*) {
+    REQUIRE_CORE(self);
+    TxStats s = self->core->stats();
+    RtConfig rt = self->core->realtime();
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:d,s:d,s:d,s:d,s:d,s:K,s:K,s:i,s:d,s:d,s:s,s:i,s:i,s:i,s:O}",
+        "ticks", (unsigned long long)s.ticks,
+        "batches", (unsigned long long)s.batches,
+        "frames_sent", (unsigned long long)s.framesSent,
+        "send_errors", (unsigned long long)s.sendErrors,
+        "overruns", (unsigned long long)s.overruns,
+        "stalls", (unsigned long long)s.stalls,
+        "wake_late_max_s", s.wakeLateMaxNs / 1e9,
+        "wake_late_avg_s", s.ticks ? (double)s.wakeLateSumNs / s.ticks / 1e9 : 0.0,
+        "launch_late_max_s", s.launchLateMaxNs / 1e9,
+        "launch_late_avg_s", s.launches ? (double)s.launchLateSumNs / s.launches / 1e9 : 0.0,
+        "txtime_lead_min_s", s.leadMinNs / 1e9,
+        "txtime_missed", (unsigned long long)s.txtimeMissed,
+        "txtime_invalid", (unsigned long long)s.txtimeInvalid,
+        "last_errno", s.lastErrno,
+        "rate_hz", self->core->rateHz(),
+        "stale_ms", self->core->staleMs(),
+        "pacing", pacingName(self->core->pacing()),
+        "rt_cpu", rt.cpu,
+        "rt_priority", rt.priority,
+        "rt_errno", s.rtErrno,
+        "running", self->core->running() ? Py_True : Py_False);
+}
+
+PyObject* Transmitter_reset_stats(TransmitterObject* self, PyObject*) {
+    REQUIRE_CORE(self);
+    self->core->resetStats();
+    Py_RETURN_NONE;
+}
+
+PyObject* Transmitter_robot_stats(TransmitterObject* self, PyObject* args) {
+    REQUIRE_CORE(self);
+    const char* id;
+    if (!PyArg_ParseTuple(args, "s", &id)) return nullptr;
+    uint64_t framesSent, errors;
+    uint16_t seq;
+    bool stale;
+    if (!self->core->robotStats(id, framesSent, errors, seq, stale)) return unknownRobot(id);
+    return Py_BuildValue("{s:K,s:K,s:i,s:O}",
+        "frames_sent", (unsigned long long)framesSent,
+        "send_errors", (unsigned long long)errors,
+        "seq", (int)seq,
+        "stale", stale ? Py_True : Py_False);
+}
+
+PyMethodDef Transmitter_methods[] = {
+    {"set_robot", (PyCFunction)Transmitter_set_robot, METH_VARARGS,
+     "set_robot(robot_id, ip, port): add a robot or update its address"},
+    {"remove_robot", (PyCFunction)Transmitter_remove_robot, METH_VARARGS,
+     "remove_robot(robot_id) -> bool"},
+    {"set_state", (PyCFunction)Transmitter_set_state, METH_VARARGS,
+     "set_state(robot_id, left_x, left_y, right_x, right_y, buttons): latest controller state; "
+     "call at least every stale_ms or the robot's frames stop"},
+    {"set_enabled", (PyCFunction)Transmitter_set_enabled, METH_VARARGS,
+     "set_enabled(robot_id, enabled): whether frames are sent to this robot"},
+    {"set_realtime", (PyCFunction)Transmitter_set_realtime, METH_VARARGS | METH_KEYWORDS,
+     "set_realtime(cpu=-1, priority=0): pin to a CPU and run SCHED_FIFO from the next start()"},
+    {"start", (PyCFunction)Transmitter_start, METH_NOARGS, "Start the transmit thread"},
+    {"stop", (PyCFunction)Transmitter_stop, METH_NOARGS, "Stop and join the transmit thread"},
+    {"stats", (PyCFunction)Transmitter_stats, METH_NOARGS, "Thread-wide counters as a dict"},
+    {"reset_stats", (PyCFunction)Transmitter_reset_stats, METH_NOARGS, "Zero the thread-wide counters"},
+    {"robot_stats", (PyCFunction)Transmitter_robot_stats, METH_VARARGS,
+     "robot_stats(robot_id) -> {frames_sent, send_errors, seq, stale}"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyObject* lock_memory(PyObject*, PyObject*) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) return PyErr_SetFromErrno(PyExc_OSError);
+    Py_RETURN_NONE;
+}
+
+PyObject* wakeup_latency(PyObject*, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {"seconds", "interval_us", "cpu", "priority", nullptr};
+    double seconds = 10.0;
+    double intervalUs = 1000.0;
+    RtConfig rt;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddii", (char**)kwlist,
+                                     &seconds, &intervalUs, &rt.cpu, &rt.priority)) return nullptr;
+    if (seconds <= 0 || intervalUs < 50) {
+        PyErr_SetString(PyExc_ValueError, "seconds must be positive and interval_us at least 50");
+        return nullptr;
+    }
+
+    LatencyResult r;
+    Py_BEGIN_ALLOW_THREADS
+    r = measureWakeupLatency(seconds, (int64_t)(intervalUs * 1000), rt);
+    Py_END_ALLOW_THREADS
+
+    return Py_BuildValue("{s:K,s:d,s:d,s:d,s:d,s:d,s:i}",
+        "samples", (unsigned long long)r.samples,
+        "min_s", r.minNs / 1e9,
+        "avg_s", r.samples ? (double)r.sumNs / r.samples / 1e9 : 0.0,
+        "max_s", r.maxNs / 1e9,
+        "p99_s", r.p99Ns / 1e9,
+        "p999_s", r.p999Ns / 1e9,
+        "rt_errno", r.rtErrno);
+}
+
+PyMethodDef moduleMethods[] = {
+    {"lock_memory", lock_memory, METH_NOARGS,
+     "lock_memory(): mlockall(MCL_CURRENT | MCL_FUTURE) for the whole process"},
+    {"wakeup_latency", (PyCFunction)wakeup_latency, METH_VARARGS | METH_KEYWORDS,
+     "wakeup_latency(seconds=10, interval_us=1000, cpu=-1, priority=0) -> dict\n"
+     "How late a thread with these real-time settings wakes from clock_nanosleep"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyTypeObject TransmitterType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+PyModuleDef stationTxModule = {
+    PyModuleDef_HEAD_INIT,
+    "station_tx",
+    "Native transmit core for the Minibot driver station",
+    -1,
+    moduleMethods
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_station_tx(void) {
+    TransmitterType.tp_name = "station_tx.Transmitter";
+    TransmitterType.tp_doc = "Transmitter(fd, rate_hz=60.0, pacing='batch', txtime_clock='tai', lead_us=1000.0, "
+        "stale_ms=250.0): sends every enabled robot's frame each tick";
+    TransmitterType.tp_basicsize = sizeof(TransmitterObject);
+    TransmitterType.tp_flags = Py_TPFLAGS_DEFAULT;
+    TransmitterType.tp_new = PyType_GenericNew;
+    TransmitterType.tp_init = (initproc)Transmitter_init;
+    TransmitterType.tp_dealloc = (destructor)Transmitter_dealloc;
+    TransmitterType.tp_methods = Transmitter_methods;
+    if (PyType_Ready(&TransmitterType) < 0) return nullptr;
+
+    PyObject* module = PyModule_Create(&stationTxModule);
+    if (!module) return nullptr;
+    Py_INCREF(&TransmitterType);
+    if (PyModule_AddObject(module, "Transmitter", (PyObject*)&TransmitterType) < 0) {
+        Py_DECREF(&TransmitterType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    PyModule_AddIntConstant(module, "FRAME_LEN", FRAME_LEN);
+    PyModule_AddIntConstant(module, "MAX_ROBOTS", MAX_ROBOTS);
+    return module;
+}
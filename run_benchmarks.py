@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Benchmark suite - firmware and station hot paths, compared against a baseline
+
+Builds the robot firmware for this machine (minibot.cpp on the host backend,
+bench/bench_firmware.cpp) and times updateController() for each packet type,
+telemetry, motor writes, input shaping and the sketch's loop(). Then times
+the station's frame encoding, send tick, native sync, packet handling and
+metrics scrape (bench/bench_station.py).
+
+Every benchmark is measured as several batches; the median is the result and
+the MAD (median absolute deviation) is its noise. A benchmark only counts as
+a regression when it is slower than the baseline by more than both:
+  - the tolerance (10% by default, 25% for ones through the socket path)
+  - 3 sigma of the combined baseline and current noise (sigma = 1.4826 * MAD)
+so a noisy run flags nothing rather than everything.
+
+Results go to bench_output.txt as JSON. Baselines are per machine, so none
+is checked in: the first run records bench/baselines.json, later runs compare
+against it. A baseline from different hardware only warns, it never fails.
+
+Usage:
+    python run_benchmarks.py                     # compare with bench/baselines.json (first run: record it)
+    python run_benchmarks.py --save-baseline     # record this run as the baseline
+    python run_benchmarks.py --filter firmware.update
+    python run_benchmarks.py --no-fail           # report regressions, exit 0
+"""
+
+import argparse
+import datetime
+import json
+import math
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+BENCH_DIR = os.path.join(ROOT, "bench")
+BUILD_DIR = os.path.join(BENCH_DIR, "build")
+BASELINE = os.path.join(BENCH_DIR, "baselines.json")
+OUTPUT = os.path.join(ROOT, "bench_output.txt")
+
+FIRMWARE_SOURCES = ["minibots/minibot.cpp", "minibots/platform_host.cpp", "bench/bench_firmware.cpp"]
+DEFAULT_TOLERANCE = 0.10
+NOISE_SIGMAS = 3.0
+MAD_TO_SIGMA = 1.4826
+
+
+def compiler_version(cxx):
+    try:
+        return subprocess.run([cxx, "--version"], capture_output=True, text=True).stdout.splitlines()[0]
+    except (OSError, IndexError):
+        return None
+
+
+def git_revision():
+    try:
+        out = subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=ROOT,
+                             capture_output=True, text=True)
+        return out.stdout.strip() or None
+    except OSError:
+        return None
+
+
+def build_firmware(cxx):
+    """Compile the host firmware benchmark; returns the binary path or None"""
+    if shutil.which(cxx) is None:
+        print(f"  {cxx} not found, skipping firmware benchmarks")
+        return None
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    binary = os.path.join(BUILD_DIR, "bench_firmware")
+    cmd = [cxx, "-O2", "-std=c++17", "-DMINIBOT_HOST", "-Ibench/host", "-Iminibots",
+           *FIRMWARE_SOURCES, "-o", binary]
+    result = subprocess.run(cmd, cwd=ROOT, capture_output=True, text=True)
+    if result.returncode != 0:
+        print(result.stderr)
+        raise SystemExit("firmware benchmark build failed")
+    return binary
+
+
+def run_suite(cmd, repeats):
+    """Run one benchmark program and parse its JSON lines"""
+    result = subprocess.run([*cmd, "--repeats", str(repeats)], cwd=ROOT, capture_output=True, text=True)
+    if result.returncode != 0:
+        print(result.stdout + result.stderr)
+        raise SystemExit(f"{os.path.basename(cmd[-1])} failed")
+    return [json.loads(line) for line in result.stdout.splitlines() if line.startswith("{")]
+
+
+def summarize(bench):
+    samples = bench["samples"]
+    median = statistics.median(samples)
+    mad = statistics.median(abs(s - median) for s in samples)
+    summary = {"unit": bench["unit"], "median": round(median, 2), "mad": round(mad, 2),
+               "min": min(samples), "samples": samples}
+    if "tolerance" in bench:
+        summary["tolerance"] = bench["tolerance"]
+    return summary
+
+
+def compare(name, current, base, tolerance):
+    """Verdict for one benchmark: (status, change ratio, threshold)"""
+    tol = current.get("tolerance", base.get("tolerance", tolerance))
+    noise = NOISE_SIGMAS * MAD_TO_SIGMA * math.hypot(base["mad"], current["mad"])
+    threshold = max(tol * base["median"], noise)
+    delta = current["median"] - base["median"]
+    ratio = delta / base["median"] if base["median"] else 0.0
+    if delta > threshold:
+        return "REGRESSION", ratio, threshold
+    if -delta > threshold:
+        return "improved", ratio, threshold
+    return "ok", ratio, threshold
+
+
+def machine_info(cxx):
+    return {
+        "machine": platform.machine(),
+        "processor": platform.processor() or None,
+        "system": f"{platform.system()} {platform.release()}",
+        "cpus": os.cpu_count(),
+        "python": platform.python_version(),
+        "compiler": compiler_version(cxx),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Firmware and station benchmarks with baseline comparison")
+    parser.add_argument("--repeat", type=int, default=15, help="batches per benchmark (default 15)")
+    parser.add_argument("--filter", default="", help="only benchmarks whose name contains this")
+    parser.add_argument("--tolerance", type=float, default=DEFAULT_TOLERANCE,
+                        help=f"allowed slowdown as a fraction (default {DEFAULT_TOLERANCE})")
+    parser.add_argument("--baseline", default=BASELINE, help="baseline file (default bench/baselines.json)")
+    parser.add_argument("--save-baseline", action="store_true", help="write this run as the baseline")
+    parser.add_argument("--no-fail", action="store_true", help="exit 0 even with regressions")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"), help="host C++ compiler")
+    args = parser.parse_args()
+
+    print("Building firmware benchmark...")
+    binary = build_firmware(args.cxx)
+
+    raw = []
+    if binary:
+        print("Running firmware benchmarks...")
+        raw += run_suite([binary], args.repeat)
+    print("Running station benchmarks...")
+    raw += run_suite([sys.executable, os.path.join(BENCH_DIR, "bench_station.py")], args.repeat)
+
+    results = {b["name"]: summarize(b) for b in raw if args.filter in b["name"]}
+    info = machine_info(args.cxx)
+    report = {
+        "date": datetime.datetime.now().isoformat(timespec="seconds"),
+        "git": git_revision(),
+        "info": info,
+        "benchmarks": results,
+    }
+
+    baseline = None
+    if os.path.exists(args.baseline) and not args.save_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    first_run = baseline is None and not args.save_baseline and not args.filter
+
+    print()
+    print(f"{'benchmark':40} {'median':>12} {'±mad':>9} {'baseline':>12} {'change':>8}  status")
+    regressions = []
+    comparisons = {}
+    for name, current in results.items():
+        base = baseline["benchmarks"].get(name) if baseline else None
+        line = f"{name:40} {current['median']:>12.1f} {current['mad']:>9.1f}"
+        if base is None:
+            print(f"{line} {'-':>12} {'-':>8}  {'new' if baseline else ''}")
+            continue
+        status, ratio, threshold = compare(name, current, base, args.tolerance)
+        comparisons[name] = {"status": status, "change": round(ratio, 4), "threshold": round(threshold, 2)}
+        if status == "REGRESSION":
+            regressions.append(name)
+        print(f"{line} {base['median']:>12.1f} {ratio:>+8.1%}  {status}")
+    print(f"(ns/op, {args.repeat} batches each)")
+
+    other_machine = False
+    if baseline:
+        report["baseline"] = {"file": os.path.relpath(args.baseline, ROOT), "date": baseline.get("date"),
+                              "git": baseline.get("git"), "comparisons": comparisons}
+        base_info = baseline.get("info", {})
+        other_machine = any(base_info.get(k) != info.get(k) for k in ("machine", "processor", "cpus"))
+        if other_machine:
+            print(f"\nWarning: baseline was recorded on {base_info.get('processor') or base_info.get('machine')}"
+                  f" ({base_info.get('cpus')} CPUs); differences may be the hardware, not the code")
+
+    with open(OUTPUT, "w") as f:
+        json.dump(report, f, indent=2)
+        f.write("\n")
+    print(f"\nResults written to {os.path.relpath(OUTPUT, ROOT)}")
+
+    if args.save_baseline or first_run:
+        if args.filter:
+            raise SystemExit("refusing to save a filtered run as the baseline")
+        saved = {k: report[k] for k in ("date", "git", "info")}
+        saved["benchmarks"] = {name: {k: v for k, v in r.items() if k != "samples"}
+                               for name, r in results.items()}
+        with open(args.baseline, "w") as f:
+            json.dump(saved, f, indent=2)
+            f.write("\n")
+        if first_run:
+            print("No baseline yet: this run is now the baseline for this machine")
+        print(f"Baseline saved to {os.path.relpath(args.baseline, ROOT)}")
+        return 0
+
+    if not baseline:
+        print("No baseline to compare with (run without --filter to record one)")
+        return 0
+    if regressions:
+        print(f"\n{len(regressions)} regression(s): {', '.join(regressions)}")
+        if other_machine:
+            print("Not failing: the baseline is from another machine (--save-baseline to record one here)")
+            return 0
+        return 0 if args.no_fail else 1
+    print("\nNo regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
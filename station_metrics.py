@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""
+Low-overhead metrics registry for the driver station
+Counters, gauges and histograms rendered in Prometheus text exposition format,
+served from a local HTTP endpoint and/or written to a textfile periodically
+"""
+
+import bisect
+import math
+import os
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Callable, Dict, Optional, Sequence, Tuple
+
+# Seconds; covers a 60 FPS frame budget and typical WiFi round trips
+DEFAULT_BUCKETS = (0.0005, 0.001, 0.0025, 0.005, 0.01, 0.0167, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0)
+
+
+class Counter:
+    """Monotonically increasing value"""
+    __slots__ = ('value',)
+
+    def __init__(self):
+        self.value = 0.0
+
+    def inc(self, amount: float = 1.0):
+        self.value += amount
+
+
+class Gauge:
+    """Value that can go up and down, or be read from a callback at scrape time"""
+    __slots__ = ('value', 'function')
+
+    def __init__(self):
+        self.value = 0.0
+        self.function: Optional[Callable[[], float]] = None
+
+    def set(self, value: float):
+        self.value = value
+
+    def inc(self, amount: float = 1.0):
+        self.value += amount
+
+    def set_function(self, function: Callable[[], float]):
+        self.function = function
+
+    def get(self) -> float:
+        if self.function is not None:
+            try:
+                return float(self.function())
+            except Exception:
+                return math.nan
+        return self.value
+
+
+class Histogram:
+    """Bucketed distribution of observations (cumulative on render)"""
+    __slots__ = ('bounds', 'counts', 'sum', 'count')
+
+    def __init__(self, bounds: Sequence[float]):
+        self.bounds = tuple(bounds)
+        self.counts = [0] * (len(self.bounds) + 1)  # last slot is +Inf
+        self.sum = 0.0
+        self.count = 0
+
+    def observe(self, value: float):
+        self.counts[bisect.bisect_left(self.bounds, value)] += 1
+        self.sum += value
+        self.count += 1
+
+
+class MetricFamily:
+    """One metric name with a child per label combination"""
+
+    def __init__(self, name: str, help_text: str, kind: str, labelnames: Tuple[str, ...],
+                 factory: Callable[[], object]):
+        self.name = name
+        self.help = help_text
+        self.kind = kind
+        self.labelnames = labelnames
+        self._factory = factory
+        self._children: Dict[Tuple[str, ...], object] = {}
+        if not labelnames:
+            self._children[()] = factory()
+
+    def labels(self, *values):
+        """Child metric for these label values (created on first use, then cached)"""
+        key = tuple(str(v) for v in values)
+        child = self._children.get(key)
+        if child is None:
+            if len(key) != len(self.labelnames):
+                raise ValueError(f"{self.name} expects labels {self.labelnames}")
+            child = self._children.setdefault(key, self._factory())
+        return child
+
+    def remove(self, *values):
+        """Drop a child, e.g. when a robot leaves. Leading label values alone
+        drop every child that starts with them (a robot's telemetry keys)."""
+        prefix = tuple(str(v) for v in values)
+        for key in [key for key in list(self._children) if key[:len(prefix)] == prefix]:
+            self._children.pop(key, None)
+
+    # Unlabelled families act as their single child
+    def inc(self, amount: float = 1.0):
+        self._children[()].inc(amount)
+
+    def set(self, value: float):
+        self._children[()].set(value)
+
+    def set_function(self, function: Callable[[], float]):
+        self._children[()].set_function(function)
+
+    def observe(self, value: float):
+        self._children[()].observe(value)
+
+    def render(self, lines: list):
+        lines.append(f"# HELP {self.name} {self.help}")
+        lines.append(f"# TYPE {self.name} {self.kind}")
+        for key, child in list(self._children.items()):
+            labels = _format_labels(self.labelnames, key)
+            if self.kind == 'histogram':
+                cumulative = 0
+                for bound, count in zip(child.bounds, child.counts):
+                    cumulative += count
+                    le = _format_labels(self.labelnames + ('le',), key + (_format_value(bound),))
+                    lines.append(f"{self.name}_bucket{le} {cumulative}")
+                le = _format_labels(self.labelnames + ('le',), key + ('+Inf',))
+                lines.append(f"{self.name}_bucket{le} {child.count}")
+                lines.append(f"{self.name}_sum{labels} {_format_value(child.sum)}")
+                lines.append(f"{self.name}_count{labels} {child.count}")
+            elif self.kind == 'gauge':
+                lines.append(f"{self.name}{labels} {_format_value(child.get())}")
+            else:
+                lines.append(f"{self.name}{labels} {_format_value(child.value)}")
+
+
+class Registry:
+    """Holds every metric family; updates are plain attribute writes, so the
+    hot paths never take a lock. Rendering copies before iterating."""
+
+    def __init__(self):
+        self._families: Dict[str, MetricFamily] = {}
+
+    def _register(self, family: MetricFamily) -> MetricFamily:
+        return self._families.setdefault(family.name, family)
+
+    def counter(self, name: str, help_text: str, labelnames: Sequence[str] = ()) -> MetricFamily:
+        return self._register(MetricFamily(name, help_text, 'counter', tuple(labelnames), Counter))
+
+    def gauge(self, name: str, help_text: str, labelnames: Sequence[str] = ()) -> MetricFamily:
+        return self._register(MetricFamily(name, help_text, 'gauge', tuple(labelnames), Gauge))
+
+    def histogram(self, name: str, help_text: str, labelnames: Sequence[str] = (),
+                  buckets: Sequence[float] = DEFAULT_BUCKETS) -> MetricFamily:
+        bounds = tuple(sorted(buckets))
+        return self._register(MetricFamily(name, help_text, 'histogram', tuple(labelnames),
+                                           lambda: Histogram(bounds)))
+
+    def render(self) -> str:
+        """Prometheus text exposition format (version 0.0.4)"""
+        lines = []
+        for family in list(self._families.values()):
+            family.render(lines)
+        return "\n".join(lines) + "\n"
+
+
+def _format_value(value: float) -> str:
+    if math.isnan(value):
+        return "NaN"
+    if math.isinf(value):
+        return "+Inf" if value > 0 else "-Inf"
+    if value == int(value) and abs(value) < 1e15:
+        return str(int(value))
+    return repr(float(value))
+
+
+def _format_labels(names: Tuple[str, ...], values: Tuple[str, ...]) -> str:
+    if not names:
+        return ""
+    pairs = []
+    for name, value in zip(names, values):
+        escaped = value.replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+        pairs.append(f'{name}="{escaped}"')
+    return "{" + ",".join(pairs) + "}"
+
+
+def start_http_server(registry: Registry, port: int, host: str = '127.0.0.1') -> ThreadingHTTPServer:
+    """Serve GET /metrics on a daemon thread; returns the server (call shutdown() to stop)"""
+
+    class MetricsHandler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path.split('?')[0] not in ('/metrics', '/'):
+                self.send_error(404)
+                return
+            body = registry.render().encode('utf-8')
+            self.send_response(200)
+            self.send_header('Content-Type', 'text/plain; version=0.0.4; charset=utf-8')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, format, *args):
+            pass  # keep scrapes out of the console
+
+    server = ThreadingHTTPServer((host, port), MetricsHandler)
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, daemon=True, name="metrics-http").start()
+    return server
+
+
+def start_textfile_writer(registry: Registry, path: str, interval: float = 5.0) -> threading.Event:
+    """Rewrite path every interval seconds (atomically, for node_exporter's
+    textfile collector). Set the returned event to stop."""
+    stop = threading.Event()
+
+    def writer():
+        while not stop.wait(interval):
+            write_textfile(registry, path)
+        write_textfile(registry, path)
+
+    threading.Thread(target=writer, daemon=True, name="metrics-textfile").start()
+    return stop
+
+
+def write_textfile(registry: Registry, path: str):
+    tmp_path = f"{path}.{os.getpid()}.tmp"
+    try:
+        with open(tmp_path, 'w', encoding='utf-8') as f:
+            f.write(registry.render())
+        os.replace(tmp_path, path)
+    except OSError as e:
+        print(f"Metrics textfile error: {e}")
+
+
+if __name__ == "__main__":
+    # Quick look at the output format
+    demo = Registry()
+    sent = demo.counter('ds_frames_sent_total', 'Control frames sent', ['robot'])
+    rtt = demo.histogram('ds_robot_rtt_seconds', 'Round trip time', ['robot'])
+    start = time.perf_counter()
+    for i in range(1000):
+        sent.labels('robot1').inc()
+        rtt.labels('robot1').observe(0.004 + (i % 7) * 0.001)
+    print(demo.render())
+    print(f"# 2000 updates in {(time.perf_counter() - start) * 1e6:.0f}us")
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Sampling profiler for the driver station
+A daemon thread snapshots every Python thread's stack with
+sys._current_frames() at a fixed rate, attributes each sample to a subsystem
+(rendering, event pumping, encoding, network, ...) and writes the stacks in
+the folded format flamegraph.pl, speedscope and inferno read.
+
+Samples are wall-clock: a thread blocked in recv() or clock.tick() is sampled
+there too, which is why waits get subsystems of their own. Native threads
+(native/station_tx) have no Python frames and don't appear.
+"""
+
+import os
+import sys
+import threading
+import time
+from collections import Counter
+from typing import Callable, Dict, Optional
+
+
+class SamplingProfiler:
+    """Start/stop any number of times; each run's samples are kept separately"""
+
+    def __init__(self, subsystems: Dict[str, str], thread_subsystems: Optional[Dict[str, str]] = None,
+                 hz: float = 100.0, thread_init: Optional[Callable[[], None]] = None):
+        # subsystems maps "file.py:function" labels to subsystem names. The
+        # innermost such frame decides a sample's subsystem; without one it's
+        # the thread's entry in thread_subsystems, or else the thread name.
+        self.subsystems = subsystems
+        self.thread_subsystems = thread_subsystems or {}
+        self.interval = 1.0 / hz
+        self.thread_init = thread_init         # run first on the sampler thread
+        self.stacks: Counter = Counter()       # "subsystem;file:func;..." -> samples
+        self.by_subsystem: Counter = Counter()
+        self.ticks = 0
+        self.started = 0.0
+        self.duration = 0.0
+        self.cpu_time = 0.0                    # the sampler thread's own CPU time
+        self._labels: Dict[object, tuple] = {}  # code object -> ("file.py:func", subsystem)
+        self._stop = threading.Event()
+        self._thread: Optional[threading.Thread] = None
+
+    @property
+    def running(self) -> bool:
+        return self._thread is not None
+
+    def start(self):
+        if self._thread is not None:
+            return
+        self.stacks.clear()
+        self.by_subsystem.clear()
+        self.ticks = 0
+        self.cpu_time = 0.0
+        self.started = time.monotonic()
+        self._stop.clear()
+        self._thread = threading.Thread(target=self._run, daemon=True, name="profiler")
+        self._thread.start()
+
+    def stop(self):
+        if self._thread is None:
+            return
+        self._stop.set()
+        self._thread.join()
+        self._thread = None
+        self.duration = time.monotonic() - self.started
+
+    def _run(self):
+        if self.thread_init:
+            self.thread_init()
+        me = threading.get_ident()
+        names: Dict[int, str] = {}
+        cpu_start = time.thread_time()
+        next_tick = time.monotonic()
+        while not self._stop.wait(max(0.0, next_tick - time.monotonic())):
+            next_tick += self.interval
+            frames = sys._current_frames()
+            if any(ident not in names for ident in frames):
+                names = {t.ident: t.name for t in threading.enumerate()}
+            for ident, frame in frames.items():
+                if ident != me:
+                    self._sample(names.get(ident, "thread"), frame)
+            del frames
+            self.ticks += 1
+        self.cpu_time = time.thread_time() - cpu_start
+
+    def _sample(self, thread_name: str, frame):
+        labels = self._labels
+        subsystem = None
+        stack = []
+        while frame is not None:
+            code = frame.f_code
+            entry = labels.get(code)
+            if entry is None:
+                label = f"{os.path.basename(code.co_filename)}:{code.co_name}"
+                entry = labels[code] = (label, self.subsystems.get(label))
+            if subsystem is None:
+                subsystem = entry[1]
+            stack.append(entry[0])
+            frame = frame.f_back
+        if subsystem is None:
+            subsystem = self.thread_subsystems.get(thread_name)
+            if subsystem is None:
+                # Threads nobody named ("Thread-3 (process_request_thread)") go together
+                subsystem = "other" if thread_name.startswith("Thread-") else thread_name
+        stack.append(subsystem)
+        stack.reverse()
+        self.stacks[";".join(stack)] += 1
+        self.by_subsystem[subsystem] += 1
+
+    def write_folded(self, path: str):
+        """One "frame;frame;... count" line per distinct stack, root first"""
+        with open(path, 'w', encoding='utf-8') as f:
+            for stack, count in self.stacks.most_common():
+                f.write(f"{stack} {count}\n")
+
+    def summary(self) -> str:
+        lines = [f"Profile: {self.duration:.1f} s, {self.ticks} ticks at {1 / self.interval:.0f} Hz, "
+                 f"sampler CPU {self.cpu_time / max(self.duration, 1e-9):.1%}"]
+        for subsystem, count in self.by_subsystem.most_common():
+            lines.append(f"  {subsystem:16} {count * self.interval:7.2f} s  ({count / max(self.ticks, 1):6.1%})")
+        return "\n".join(lines)
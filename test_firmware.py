@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+Test the robot firmware's behaviour on a host build (minibot.cpp on the host
+backend, bench/test_firmware.cpp), one process per test
+Needs a C++17 compiler (g++ by default, or set CXX)
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+BUILD_DIR = os.path.join(ROOT, "bench", "build")
+SOURCES = ["minibots/minibot.cpp", "minibots/platform_host.cpp", "bench/test_firmware.cpp"]
+
+TESTS = [
+    "playout_clumps",
+    "estop_through_flood",
+    "rejoin_schedule",
+    "survey_rejoin_timeout",
+]
+
+
+def build(cxx):
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    binary = os.path.join(BUILD_DIR, "test_firmware")
+    cmd = [cxx, "-O1", "-std=c++17", "-Wall", "-DMINIBOT_HOST", "-Ibench/host", "-Iminibots",
+           *SOURCES, "-o", binary]
+    result = subprocess.run(cmd, cwd=ROOT, capture_output=True, text=True)
+    if result.returncode != 0:
+        print(result.stderr)
+        raise SystemExit("[FAIL] host firmware build failed")
+    return binary
+
+
+if __name__ == "__main__":
+    cxx = os.environ.get("CXX", "g++")
+    if shutil.which(cxx) is None:
+        print(f"[SKIP] {cxx} not found")
+        sys.exit(0)
+
+    print("Running host firmware tests...\n")
+    binary = build(cxx)
+    failed = 0
+    for name in TESTS:
+        result = subprocess.run([binary, name], capture_output=True, text=True)
+        print(result.stdout.rstrip())
+        if result.returncode != 0:
+            failed += 1
+
+    if failed:
+        print(f"\n[FAIL] {failed} host firmware test(s) failed")
+        sys.exit(1)
+    print("\n[SUCCESS] All host firmware tests passed!")
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+Test the native transmit core (native/station_tx) against the Python encoder
+Build it first: cd native && python setup.py build_ext --inplace
+"""
+
+import os
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "native"))
+
+try:
+    import station_tx
+except ImportError:
+    station_tx = None
+
+
+def python_frame(robot_id, axes, buttons, seq, stamp):
+    """Same layout driver_station._send_controller_data() builds"""
+    name = robot_id.encode('utf-8')[:15].ljust(16, b'\x00')
+    return name + struct.pack('BBBBBB', *axes, 127, 127) + struct.pack('BB', buttons, 0) + \
+        struct.pack('<HI', seq, stamp)
+
+
+def make_receiver():
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', 0))
+    sock.settimeout(1.0)
+    return sock, sock.getsockname()[1]
+
+
+def test_frame_format():
+    """Native frames must be byte-identical to the Python encoder's"""
+    robot, port = make_receiver()
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sender.fileno(), 200.0)
+    tx.set_robot("TestRobotLongName", "127.0.0.1", port)
+    tx.set_state("TestRobotLongName", 10, 20, 300, -5, 0x05)
+    tx.set_enabled("TestRobotLongName", True)
+
+    before = int(time.monotonic() * 1000) & 0xFFFFFFFF
+    tx.start()
+    data, _ = robot.recvfrom(64)
+    tx.stop()
+    after = int(time.monotonic() * 1000) & 0xFFFFFFFF
+
+    assert len(data) == station_tx.FRAME_LEN == 30, f"Frame length should be 30, got {len(data)}"
+    seq, stamp = struct.unpack('<HI', data[24:30])
+    assert seq == 1, f"First frame should carry seq 1, got {seq}"
+    assert before <= stamp <= after, f"Stamp {stamp} not on the time.monotonic() ms clock"
+
+    # Axes are clamped to 0-255 like the Python path
+    expected = python_frame("TestRobotLongName", (10, 20, 255, 0), 0x05, seq, stamp)
+    assert data == expected, f"Frame mismatch:\n  native {data.hex()}\n  python {expected.hex()}"
+
+    robot.close()
+    sender.close()
+    print("[OK] Native frame format test passed!")
+
+
+def test_batching_and_policy():
+    """One sendmmsg per tick covers every enabled robot; disabled ones get nothing"""
+    receivers = [make_receiver() for _ in range(3)]
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sender.fileno(), 100.0, stale_ms=5000)
+    for i, (_, port) in enumerate(receivers):
+        tx.set_robot(f"robot{i}", "127.0.0.1", port)
+        tx.set_enabled(f"robot{i}", i != 1)
+
+    tx.start()
+    time.sleep(0.25)
+    tx.stop()
+
+    stats = tx.stats()
+    assert stats['ticks'] >= 15, f"Expected ~25 ticks at 100 Hz, got {stats['ticks']}"
+    assert stats['batches'] == stats['ticks'], "Expected exactly one sendmmsg per tick"
+    assert stats['send_errors'] == 0, f"Unexpected send errors: {stats}"
+    assert tx.robot_stats("robot1")['frames_sent'] == 0, "Disabled robot should not get frames"
+    assert tx.robot_stats("robot0")['frames_sent'] == stats['ticks'], "Enabled robot should get one frame per tick"
+
+    receivers[0][0].settimeout(0.1)
+    count = 0
+    try:
+        while True:
+            receivers[0][0].recvfrom(64)
+            count += 1
+    except socket.timeout:
+        pass
+    assert count == stats['ticks'], f"robot0 received {count} of {stats['ticks']} frames"
+
+    assert tx.remove_robot("robot2"), "remove_robot should report success"
+    try:
+        tx.set_state("robot2", 0, 0, 0, 0, 0)
+        assert False, "set_state on a removed robot should raise KeyError"
+    except KeyError:
+        pass
+
+    for sock, _ in receivers:
+        sock.close()
+    sender.close()
+    print("[OK] Native batching and policy test passed!")
+
+
+def test_soft_pacing():
+    """Paced frames for two robots leave half a tick apart instead of back to back"""
+    receivers = [make_receiver() for _ in range(2)]
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sender.fileno(), 50.0, pacing="soft", stale_ms=5000)
+    for i, (_, port) in enumerate(receivers):
+        tx.set_robot(f"robot{i}", "127.0.0.1", port)
+        tx.set_enabled(f"robot{i}", True)
+
+    tx.start()
+    time.sleep(0.3)
+    tx.stop()
+
+    stats = tx.stats()
+    assert stats['pacing'] == "soft", f"Unexpected pacing {stats['pacing']}"
+    assert stats['frames_sent'] == 2 * stats['ticks'], f"Every robot should get a frame per tick: {stats}"
+
+    # The stamp is the frame's launch time: robot1's is 10ms (half of 20ms) after robot0's
+    stamps = []
+    for sock, _ in receivers:
+        data, _ = sock.recvfrom(64)
+        stamps.append(struct.unpack('<I', data[26:30])[0])
+    offset = (stamps[1] - stamps[0]) % 20
+    assert 8 <= offset <= 12, f"robot1 should launch ~10ms after robot0, got {offset}ms"
+
+    try:
+        station_tx.Transmitter(sender.fileno(), 50.0, pacing="bogus")
+        assert False, "Unknown pacing should raise ValueError"
+    except ValueError:
+        pass
+
+    for sock, _ in receivers:
+        sock.close()
+    sender.close()
+    print("[OK] Native soft pacing test passed!")
+
+
+def test_stale_deadline():
+    """Frames stop once Python stops refreshing a robot, and resume when it does again"""
+    robot, port = make_receiver()
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sender.fileno(), 100.0, stale_ms=100)
+    tx.set_robot("robot0", "127.0.0.1", port)
+    tx.set_enabled("robot0", True)
+    tx.start()
+
+    # Refreshed every tick or so: keeps sending
+    for _ in range(15):
+        tx.set_state("robot0", 200, 127, 127, 127, 0)
+        time.sleep(0.01)
+    assert not tx.robot_stats("robot0")['stale'], "Refreshed robot should not be stale"
+
+    # The "interpreter hangs": no more set_state calls
+    time.sleep(0.3)
+    stalled = tx.robot_stats("robot0")
+    assert stalled['stale'], "Robot should be stale 300ms after its last refresh"
+    time.sleep(0.2)
+    assert tx.robot_stats("robot0")['frames_sent'] == stalled['frames_sent'], "Stale robot should get no frames"
+    assert tx.stats()['stalls'] == 1, f"Expected one stall, got {tx.stats()['stalls']}"
+
+    # Nothing was sent more than stale_ms (+ a tick) after the last refresh
+    robot.settimeout(0.1)
+    frames = 0
+    try:
+        while True:
+            robot.recvfrom(64)
+            frames += 1
+    except socket.timeout:
+        pass
+    assert frames == stalled['frames_sent'], f"Received {frames} frames, stats say {stalled['frames_sent']}"
+    assert frames <= 15 * 2 + 12, f"Too many frames for ~250ms of activity: {frames}"
+
+    tx.set_state("robot0", 127, 127, 127, 127, 0)
+    time.sleep(0.05)
+    tx.stop()
+    assert tx.robot_stats("robot0")['frames_sent'] > stalled['frames_sent'], "Refresh should resume sending"
+
+    try:
+        station_tx.Transmitter(sender.fileno(), 100.0, stale_ms=1)
+        assert False, "stale_ms under one period should raise ValueError"
+    except ValueError:
+        pass
+
+    robot.close()
+    sender.close()
+    print("[OK] Native staleness deadline test passed!")
+
+
+def test_realtime_self_test():
+    """wakeup_latency() samples at the requested rate; set_realtime() validates its priority"""
+    result = station_tx.wakeup_latency(0.2, 1000.0)
+    assert 150 <= result['samples'] <= 200, f"Expected ~200 samples, got {result['samples']}"
+    assert 0 <= result['min_s'] <= result['avg_s'] <= result['max_s'], f"Inconsistent latencies: {result}"
+    assert result['p99_s'] <= result['max_s'] + 1e-6, f"p99 above max: {result}"
+
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx = station_tx.Transmitter(sender.fileno(), 60.0)
+    try:
+        tx.set_realtime(cpu=0, priority=1000)
+        assert False, "Out-of-range SCHED_FIFO priority should raise ValueError"
+    except ValueError:
+        pass
+    tx.set_realtime(cpu=0, priority=0)
+    assert tx.stats()['rt_cpu'] == 0, "set_realtime() should be reflected in stats()"
+    sender.close()
+    print("[OK] Native real-time self-test passed!")
+
+
+if __name__ == "__main__":
+    if station_tx is None:
+        print("[SKIP] native/station_tx is not built (cd native && python setup.py build_ext --inplace)")
+        sys.exit(0)
+
+    print("Running native transmit core tests...\n")
+
+    test_frame_format()
+    test_batching_and_policy()
+    test_soft_pacing()
+    test_stale_deadline()
+    test_realtime_self_test()
+
+    print("\n[SUCCESS] All native transmit tests passed!")
@@ -62,6 +62,61 @@ def test_controller_packet():
     
     print("[OK] Controller packet format test passed!")
 
+def test_stamped_controller_packet():
+    """Test the sequence/timestamp trailer used by the playout buffer"""
+    robot_id = "TestRobot"
+    base = robot_id.encode('utf-8')[:15].ljust(16, b'\x00')
+    base += struct.pack('BBBBBB', 127, 127, 127, 127, 127, 127) + struct.pack('BB', 0, 0)
+
+    seq = 65535
+    stamp = 0xFFFFFFF0
+    packet = base + struct.pack('<HI', seq, stamp)
+
+    assert len(packet) == 30, f"Stamped packet size should be 30, got {len(packet)}"
+    assert packet[:24] == base, "First 24 bytes must stay compatible with old robots"
+
+    # Decode the way minibot.cpp does
+    p = packet
+    parsed_seq = p[24] | (p[25] << 8)
+    parsed_stamp = p[26] | (p[27] << 8) | (p[28] << 16) | (p[29] << 24)
+    assert parsed_seq == seq, f"Sequence mismatch: {parsed_seq}"
+    assert parsed_stamp == stamp, f"Timestamp mismatch: {parsed_stamp}"
+
+    # Sequence numbers wrap; the robot compares them as int16 differences
+    next_seq = (seq + 1) & 0xFFFF
+    diff = ((next_seq - seq + 0x8000) & 0xFFFF) - 0x8000
+    assert diff == 1, f"Wrapped sequence should be newer, diff={diff}"
+
+    print("[OK] Stamped controller packet test passed!")
+
+def test_telemetry_message():
+    """Test telemetry message format"""
+    message = "TELEM:TestRobot:rx=120,seq=7,jb=2,jbd=14,late=0"
+    parts = message.split(":", 2)
+
+    assert parts[0] == "TELEM", "First part should be TELEM"
+    assert parts[1] == "TestRobot", "Robot ID should be TestRobot"
+    fields = dict(item.split("=") for item in parts[2].split(","))
+    assert fields["jb"] == "2", "Playout depth should be 2"
+    assert fields["late"] == "0", "Late drops should be 0"
+
+    print("[OK] Telemetry message format test passed!")
+
+def test_survey_report():
+    """Test channel survey report format (minibot.cpp sendSurveyReport)"""
+    message = "SURVEY:TestRobot:ap=6,dwell=150,off=4200,c1=2/-61/143/410,c6=5/-48/312/905,c11=0/0/12/30"
+    parts = message.split(":", 2)
+
+    assert parts[0] == "SURVEY", "First part should be SURVEY"
+    assert parts[1] == "TestRobot", "Robot ID should be TestRobot"
+    fields = dict(item.split("=") for item in parts[2].split(","))
+    assert fields["ap"] == "6", "AP channel should be 6"
+    networks, rssi, busy, frames = (int(v) for v in fields["c6"].split("/"))
+    assert (networks, rssi, busy, frames) == (5, -48, 312, 905), "Channel fields are networks/rssi/busy/frames"
+    assert 0 <= busy <= 1000, "Busy time is in permille"
+
+    print("[OK] Survey report format test passed!")
+
 def test_discovery_message():
     """Test discovery message format"""
     robot_id = "TestRobot"
@@ -74,6 +129,14 @@ def test_discovery_message():
     assert parts[0] == "DISCOVER", "First part should be DISCOVER"
     assert parts[1] == robot_id, f"Robot ID should be {robot_id}"
     assert parts[2] == ip, f"IP should be {ip}"
+
+    # A second robot on a board that already has a command port (minibot.cpp
+    # sendDiscoveryPing): the 4th field is still the reply port, the shared
+    # command port comes with its own marker
+    message = f"DISCOVER:{robot_id}:{ip}:12345:shared=12347"
+    parts = message.split(":")
+    assert int(parts[3]) == 12345, "Reply port should be the discovery port"
+    assert parts[4] == "shared=12347", "Shared command port should be marked"
     
     print("[OK] Discovery message format test passed!")
 
@@ -141,6 +204,9 @@ if __name__ == "__main__":
     print("Running protocol compatibility tests...\n")
     
     test_controller_packet()
+    test_stamped_controller_packet()
+    test_telemetry_message()
+    test_survey_report()
     test_discovery_message()
     test_port_assignment()
     test_game_status()